@@ -130,6 +130,8 @@ struct ad_Menu {
     size_t              itemCount;
     ad_MultiLineText   *prompt;
     ad_TextElement     *items;
+    const char         *hotkeys;
+    uint32_t            hotkey;
 };
 
 struct ad_ConsoleConfig {
@@ -18,6 +18,7 @@
 #include "anbui.h"
 #include "ad_priv.h"
 #include "ad_hal.h"
+#include "scan.h"
 
 static inline void ad_textElementAssignWithLength(ad_TextElement *el, const char *text, size_t length) {
     length = AD_MIN(AD_TEXT_ELEMENT_SIZE-1, length);
@@ -62,29 +63,29 @@ ad_TextElement* ad_textElementArrayFromString(const char *str, size_t *lineCount
     const char *upperBound;
     ad_TextElement *ret = NULL;
     const char *curPos = str;
+    size_t maxLines;
 
     AD_RETURN_ON_NULL(str, NULL);
-    ret = calloc(1, sizeof(ad_TextElement));
-    AD_RETURN_ON_NULL(ret, NULL);
 
     upperBound = str + strlen(str);
     *lineCountOut = 0;
 
+    /* Count first so large files don't realloc once per line */
+    maxLines = scan_count_byte(str, upperBound, '\n') + 1;
+    ret = calloc(maxLines, sizeof(ad_TextElement));
+    AD_RETURN_ON_NULL(ret, NULL);
+
     while (curPos < upperBound) {
         /* String is from current position until newline */
-        const char *curEnd = strchr(curPos, '\n');
-        const size_t curLen = (curEnd != NULL) ? (size_t) (curEnd - curPos) : strlen(curPos);
+        const char *curEnd = scan_newline(curPos, upperBound);
+        const size_t curLen = (size_t) (curEnd - curPos);
         
         *lineCountOut += 1;
-        
-        ret = ad_textElementArrayResize(ret, *lineCountOut);
-
-        AD_RETURN_ON_NULL(ret, NULL);
 
         ad_textElementAssignWithLength(&ret[(*lineCountOut)-1], curPos, curLen);
 
         /* Deal with annoying \r\n stuff */
-        if (curLen > 0 && curPos[curLen-1] == '\r') {
+        if (curLen > 0 && curLen < AD_TEXT_ELEMENT_SIZE && curPos[curLen-1] == '\r') {
             ret[(*lineCountOut)-1].text[curLen-1] = 0x00;
         }
 
@@ -24,6 +24,8 @@
 
 static void ad_textFileBoxDestroy(ad_TextFileBox *tfb);
 
+static void (*ad_s_menuReadyHook)(void) = NULL;
+
 static void ad_menuSelectItemAndDraw(ad_Menu *menu, size_t newSelection) {
     assert(menu);
     ad_displayStringCropped(menu->items[menu->currentSelection].text,   menu->itemX, menu->itemY + menu->currentSelection, menu->itemWidth, ad_s_con.objectBg, ad_s_con.objectFg);
@@ -108,10 +110,29 @@ inline size_t ad_menuGetItemCount(ad_Menu *menu) {
     return menu ? menu->itemCount : 0;
 }
 
+void ad_menuSetHotkeys(ad_Menu *menu, const char *keys) {
+    assert(menu);
+    menu->hotkeys = keys;
+}
+
+void ad_setMenuReadyHook(void (*hook)(void)) {
+    ad_s_menuReadyHook = hook;
+}
+
+uint32_t ad_menuGetHotkey(ad_Menu *menu) {
+    return menu ? menu->hotkey : 0;
+}
+
 int32_t ad_menuExecute(ad_Menu *menu) {
     uint32_t ch;
 
     ad_menuPaint(menu);
+    menu->hotkey = 0;
+
+    if (ad_s_menuReadyHook) {
+        fflush(stdout);
+        ad_s_menuReadyHook();
+    }
 
     while (true) {
         ch = ad_getKey();
@@ -124,6 +145,9 @@ int32_t ad_menuExecute(ad_Menu *menu) {
             return menu->currentSelection;
         } else if   (menu->cancelable && (ch == AD_KEY_ESC)) {
             return -1;
+        } else if   (menu->hotkeys && ch > 0 && ch < 0x100 && strchr(menu->hotkeys, (int) ch)) {
+            menu->hotkey = ch;
+            return AD_HOTKEY;
         } 
 #if DEBUG
         else {
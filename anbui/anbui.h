@@ -19,6 +19,7 @@
 #define AD_YESNO_YES    (0)
 #define AD_YESNO_NO     (1)
 #define AD_CANCELED     (-1)
+#define AD_HOTKEY       (-2)
 #define AD_ERROR        (-INT32_MAX)
 
 typedef struct ad_TextFileBox   ad_TextFileBox;
@@ -51,6 +52,13 @@ size_t          ad_menuGetItemCount     (ad_Menu *menu);
                     2) AD_CANCELED for a cancelled menu (if menu was created as 'cancelable')
                     3) AD_ERROR if something blew up (null pointer or something) */
 int32_t         ad_menuExecute          (ad_Menu *menu);
+/*  Sets plain character keys that end ad_menuExecute with AD_HOTKEY instead of a selection.
+    The string is not copied and must outlive the menu. */
+void            ad_menuSetHotkeys       (ad_Menu *menu, const char *keys);
+/*  Returns the hotkey that ended the last ad_menuExecute (0 if none did) */
+uint32_t        ad_menuGetHotkey        (ad_Menu *menu);
+/*  Sets a function called whenever a menu has been painted and is about to wait for input (NULL clears it) */
+void            ad_setMenuReadyHook     (void (*hook)(void));
 /*  Deallocates menu. */
 void            ad_menuDestroy          (ad_Menu *menu);
 /*  Launches a menu directly with the given options array and a formatted prompt. No (de)allocations need to be made.
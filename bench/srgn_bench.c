@@ -0,0 +1,286 @@
+/*
+ * srgn_bench: uEnv parser / state / writer microbenchmarks
+ *
+ * Generates synthetic uEnv files (tiny .. 100k lines, a few .. thousands of
+ * tokens, CRLF endings, missing final newline, duplicate keys) in a tmpfs
+ * directory and times uenv_load, cfg_state_init_from_uenv, serialization of
+ * the interface=/ext= lines and uenv_write_preserve.
+ *
+ * Output is one JSON object per line:
+ *   {"case":..,"phase":..,"lines":..,"tokens":..,"iters":..,"ns_per_op":..,
+ *    "ns_per_line":..,"allocs_per_op":..,"alloc_bytes_per_op":..,"peak_rss_kb":..}
+ *
+ * usage: srgn_bench [--dir DIR] [--min-ms N] [--case NAME] [--device REV[:SCREEN]]
+ *
+ * The revision comes from --device, else $SRGN_DEVICE, else 0.5; flash is
+ * never read.
+ */
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+#include "device.h"
+#include "uenv.h"
+
+/* ---- allocation accounting (glibc: interpose the public allocator entry points) ---- */
+
+static uint64_t s_alloc_count;
+static uint64_t s_alloc_bytes;
+
+#if defined(__GLIBC__)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    s_alloc_count++;
+    s_alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    s_alloc_count++;
+    s_alloc_bytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    s_alloc_count++;
+    s_alloc_bytes += size;
+    return __libc_realloc(ptr, size);
+}
+# define BENCH_HAVE_ALLOC_STATS 1
+#else
+# define BENCH_HAVE_ALLOC_STATS 0
+#endif
+
+/* ---- corpus generation ---- */
+
+typedef struct {
+    const char *name;
+    size_t lines;       /* filler lines around the keys */
+    size_t tokens;      /* tokens per interface=/ext= line */
+    bool crlf;
+    bool final_nl;
+    bool dup_keys;      /* repeat interface=/ext= later in the file */
+} bench_case_t;
+
+static const bench_case_t CASES[] = {
+    {.name = "tiny",        .lines = 4,      .tokens = 3,    .crlf = false, .final_nl = true,  .dup_keys = false},
+    {.name = "small",       .lines = 100,    .tokens = 10,   .crlf = false, .final_nl = true,  .dup_keys = false},
+    {.name = "small_crlf",  .lines = 100,    .tokens = 10,   .crlf = true,  .final_nl = true,  .dup_keys = false},
+    {.name = "medium",      .lines = 10000,  .tokens = 100,  .crlf = false, .final_nl = false, .dup_keys = true},
+    {.name = "large",       .lines = 100000, .tokens = 100,  .crlf = true,  .final_nl = false, .dup_keys = true},
+    {.name = "wide_tokens", .lines = 50,     .tokens = 5000, .crlf = false, .final_nl = true,  .dup_keys = false},
+};
+
+static void gen_tokens(FILE *fp, const cfg_registry_t *reg, cfg_category_t cat, size_t n) {
+    size_t written = 0;
+    /* known items of this category first, then vendor tokens with some repeats */
+    for (size_t i = 0; i < reg->count && written < n; i++) {
+        if (reg->items[i].cat != cat) continue;
+        fprintf(fp, "%s%s", written ? " " : "", reg->items[i].id);
+        written++;
+    }
+    for (size_t i = 0; written < n; i++, written++) {
+        fprintf(fp, " vendor_%s_%zu", cat == CFG_CAT_INTERFACE ? "if" : "ext", (i % 7 == 3) ? i / 2 : i);
+    }
+}
+
+static int gen_file(const char *path, const bench_case_t *c, const cfg_registry_t *reg) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return -1;
+    const char *eol = c->crlf ? "\r\n" : "\n";
+
+    fprintf(fp, "bootargs=console=ttyS0,115200 console=tty0 panic=5 rootwait root=ubi0:rootfs rw%s", eol);
+    fprintf(fp, "kernelfn=zImage%s", eol);
+    for (size_t i = 0; i < c->lines / 2; i++) fprintf(fp, "# filler %zu%s", i, eol);
+    fputs("interface=", fp);
+    gen_tokens(fp, reg, CFG_CAT_INTERFACE, c->tokens);
+    fputs(eol, fp);
+    fputs("ext=", fp);
+    gen_tokens(fp, reg, CFG_CAT_EXT, c->tokens);
+    fputs(eol, fp);
+    for (size_t i = c->lines / 2; i < c->lines; i++) fprintf(fp, "var_%zu=value_%zu%s", i, i, eol);
+    if (c->dup_keys) fprintf(fp, "interface=shadowed%sext=shadowed%s", eol, eol);
+    fprintf(fp, "uenvcmd=run bootcmd%s", c->final_nl ? eol : "");
+
+    return fclose(fp);
+}
+
+/* ---- timing ---- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+    return ru.ru_maxrss;
+}
+
+typedef enum {
+    PHASE_LOAD = 0,
+    PHASE_STATE,
+    PHASE_SERIALIZE,
+    PHASE_WRITE,
+    PHASE_COUNT,
+} bench_phase_t;
+
+static const char *const PHASE_NAMES[PHASE_COUNT] = {"load", "state", "serialize", "write"};
+
+typedef struct {
+    const char *src_path;
+    const char *out_path;
+    const cfg_registry_t *reg;
+    device_rev_t rev;
+    uenv_file_t u;
+    cfg_state_t st;
+    cfg_lines_t lines; /* rendered once in setup, re-rendered in place by PHASE_SERIALIZE */
+} bench_ctx_t;
+
+/* One iteration of a phase. Setup for later phases is done outside the timed region. */
+static int run_phase(bench_ctx_t *b, bench_phase_t ph) {
+    char err[256];
+    switch (ph) {
+        case PHASE_LOAD: {
+            uenv_file_t u;
+            if (uenv_load(b->src_path, &u, err, sizeof(err)) != 0) return -1;
+            uenv_free(&u);
+            return 0;
+        }
+        case PHASE_STATE: {
+            cfg_state_t st;
+            if (cfg_state_init_from_uenv(&st, b->reg, &b->u, b->rev) != 0) return -1;
+            cfg_state_free(&st);
+            return 0;
+        }
+        case PHASE_SERIALIZE:
+            return cfg_state_render(&b->st, &b->lines);
+        case PHASE_WRITE:
+            return uenv_write_preserve(b->out_path, &b->u, b->lines.interface_line, b->lines.ext_line, err, sizeof(err));
+        default:
+            return -1;
+    }
+}
+
+static int bench_case(const bench_case_t *c, const char *dir, uint64_t min_ns, const cfg_registry_t *reg,
+                      device_rev_t rev) {
+    char src[512];
+    char out[512];
+    char err[256];
+    snprintf(src, sizeof(src), "%s/srgn_bench_%s.txt", dir, c->name);
+    snprintf(out, sizeof(out), "%s/srgn_bench_%s.out", dir, c->name);
+    if (gen_file(src, c, reg) != 0) {
+        fprintf(stderr, "srgn_bench: failed to generate %s\n", src);
+        return -1;
+    }
+
+    bench_ctx_t b = {.src_path = src, .out_path = out, .reg = reg, .rev = rev};
+    if (uenv_load(src, &b.u, err, sizeof(err)) != 0 ||
+        cfg_state_init_from_uenv(&b.st, reg, &b.u, rev) != 0 ||
+        cfg_state_render(&b.st, &b.lines) != 0) {
+        fprintf(stderr, "srgn_bench: %s: setup failed\n", c->name);
+        return -1;
+    }
+
+    int ret = 0;
+    const size_t lines = b.u.line_count;
+    for (int ph = 0; ph < PHASE_COUNT && ret == 0; ph++) {
+        /* warm up once, then repeat until min_ns has elapsed (at least 3 iterations) */
+        if (run_phase(&b, (bench_phase_t)ph) != 0) {
+            ret = -1;
+            break;
+        }
+        uint64_t iters = 0;
+        const uint64_t a0 = s_alloc_count;
+        const uint64_t b0 = s_alloc_bytes;
+        const uint64_t t0 = now_ns();
+        uint64_t t1 = t0;
+        while (iters < 3 || t1 - t0 < min_ns) {
+            if (run_phase(&b, (bench_phase_t)ph) != 0) {
+                ret = -1;
+                break;
+            }
+            iters++;
+            t1 = now_ns();
+        }
+        const double ns_op = (double)(t1 - t0) / (double)iters;
+        printf("{\"case\":\"%s\",\"phase\":\"%s\",\"lines\":%zu,\"tokens\":%zu,\"crlf\":%s,\"final_nl\":%s,"
+               "\"dup_keys\":%s,\"iters\":%llu,\"ns_per_op\":%.1f,\"ns_per_line\":%.2f,",
+               c->name, PHASE_NAMES[ph], lines, c->tokens * 2,
+               c->crlf ? "true" : "false", c->final_nl ? "true" : "false", c->dup_keys ? "true" : "false",
+               (unsigned long long)iters, ns_op, lines ? ns_op / (double)lines : 0.0);
+        if (BENCH_HAVE_ALLOC_STATS) {
+            printf("\"allocs_per_op\":%.1f,\"alloc_bytes_per_op\":%.1f,",
+                   (double)(s_alloc_count - a0) / (double)iters, (double)(s_alloc_bytes - b0) / (double)iters);
+        } else {
+            printf("\"allocs_per_op\":null,\"alloc_bytes_per_op\":null,");
+        }
+        printf("\"peak_rss_kb\":%ld}\n", peak_rss_kb());
+        fflush(stdout);
+    }
+    if (ret != 0) fprintf(stderr, "srgn_bench: %s: phase failed\n", c->name);
+
+    cfg_lines_free(&b.lines);
+    cfg_state_free(&b.st);
+    uenv_free(&b.u);
+    unlink(src);
+    unlink(out);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = NULL;
+    const char *only = NULL;
+    long min_ms = 200;
+    const char *device = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && (i + 1) < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--min-ms") == 0 && (i + 1) < argc) {
+            min_ms = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--case") == 0 && (i + 1) < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && (i + 1) < argc) {
+            device = argv[++i];
+        } else {
+            fprintf(stderr, "usage: srgn_bench [--dir DIR] [--min-ms N] [--case NAME] [--device REV[:SCREEN]]\n");
+            return 1;
+        }
+    }
+    if (!dir) {
+        /* prefer tmpfs so the write phase measures the writer, not the disk */
+        dir = (access("/dev/shm", W_OK) == 0) ? "/dev/shm" : (getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+    }
+
+    device_info_t info = {.rev = DEVICE_REV_EPASS_0_5};
+    char err[160];
+    const device_provider_t override = {"override", device_provider_override_get, device};
+    const device_provider_t *const providers[] = {&override, &DEVICE_PROVIDER_ENV};
+    if (device_info_probe(providers, 2, &info, NULL, err, sizeof(err)) != 0 && err[0]) {
+        fprintf(stderr, "srgn_bench: %s\n", err);
+        return 1;
+    }
+
+    const cfg_registry_t *reg = cfg_registry_get();
+    int ret = 0;
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        if (only && strcmp(only, CASES[i].name) != 0) continue;
+        if (bench_case(&CASES[i], dir, (uint64_t)min_ms * 1000000ull, reg, info.rev) != 0) ret = 1;
+    }
+    return ret;
+}
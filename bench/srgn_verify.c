@@ -0,0 +1,828 @@
+/*
+ * srgn_verify: exhaustive check of the configuration engine
+ *
+ * For every device revision, walks every state reachable from the empty
+ * configuration through cfg_state_toggle (each item, with the confirm
+ * callback answering yes / no / absent) and compares each step against a
+ * reference model built directly from the item table:
+ *   - every reachable state is valid (availability, requirements, no
+ *     conflicting pair enabled);
+ *   - each toggle returns the expected code and produces exactly the
+ *     expected state (nothing changes when a toggle is refused);
+ *   - every valid state is reachable;
+ *   - the registry's precomputed masks and cfg_item_is_available agree with
+ *     the reference model.
+ *
+ * Items that are interchangeable on a revision (same availability, same
+ * requirements, same users, same conflicts) are grouped; states are stored
+ * in a canonical form where each group's enabled members come first, so only
+ * one state per symmetry orbit is visited. Valid states are enumerated per
+ * group with conflict-mask pruning. The walk is level-synchronous with the
+ * frontier of each level split across worker threads.
+ *
+ * --synthetic N verifies a generated N-item registry instead of the
+ * built-in one (to time the verifier on larger tables).
+ *
+ * usage: srgn_verify [--jobs N] [--rev REV] [--synthetic N] [--seed S]
+ *                    [--max-states N] [--no-symmetry]
+ *
+ * Exit codes: 0 no violation, 1 usage, 2 setup error / state limit hit,
+ * 3 violations found.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+
+#define VERIFY_MAX_REPORTS 20
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* ---- reference model (from the item table, independent of cfg_registry_build_masks) ---- */
+
+typedef struct {
+    const cfg_registry_t *reg;
+    int rank;
+    device_rev_t rev;
+    size_t n;
+
+    cfg_bits_t avail;
+    cfg_bits_t req[CFG_MAX_ITEMS];     /* direct requirements */
+    cfg_bits_t req_col[CFG_MAX_ITEMS]; /* items that directly require i */
+    cfg_bits_t closure[CFG_MAX_ITEMS]; /* transitive requirements, including i */
+    cfg_bits_t users[CFG_MAX_ITEMS];   /* items whose closure contains i, excluding i */
+    cfg_bits_t conf[CFG_MAX_ITEMS];    /* pin overlap or listed conflict, symmetric */
+
+    /* symmetry groups: members of group g are items[start[g] .. start[g+1]) */
+    size_t group_count;
+    size_t group_start[CFG_MAX_ITEMS + 1];
+    uint16_t group_items[CFG_MAX_ITEMS];
+    cfg_bits_t group_mask[CFG_MAX_ITEMS];
+} ref_model_t;
+
+static int find_linear(const cfg_registry_t *reg, const char *id) {
+    for (size_t i = 0; i < reg->count; i++) {
+        if (strcmp(reg->items[i].id, id) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool lists_id(const char *const *v, size_t n, const char *id) {
+    for (size_t i = 0; i < n; i++) {
+        if (v[i] && strcmp(v[i], id) == 0) return true;
+    }
+    return false;
+}
+
+static bool interchangeable(const ref_model_t *m, size_t i, size_t j) {
+    if (cfg_bits_test(&m->avail, i) != cfg_bits_test(&m->avail, j)) return false;
+    if (cfg_bits_test(&m->req[i], j) || cfg_bits_test(&m->req[j], i)) return false;
+    if (!cfg_bits_equal(&m->req[i], &m->req[j])) return false;
+    if (!cfg_bits_equal(&m->req_col[i], &m->req_col[j])) return false;
+    cfg_bits_t ci = m->conf[i];
+    cfg_bits_t cj = m->conf[j];
+    cfg_bits_clear(&ci, j);
+    cfg_bits_clear(&cj, i);
+    return cfg_bits_equal(&ci, &cj);
+}
+
+static int ref_build(ref_model_t *m, const cfg_registry_t *reg, int rank, bool symmetry, char *err, size_t err_len) {
+    memset(m, 0, sizeof(*m));
+    m->reg = reg;
+    m->rank = rank;
+    m->rev = (device_rev_t)rank;
+    m->n = reg->count;
+    const size_t n = m->n;
+
+    for (size_t i = 0; i < n; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        if ((it->min_rev_rank < 0 || rank >= it->min_rev_rank) && (it->max_rev_rank < 0 || rank <= it->max_rev_rank)) {
+            cfg_bits_set(&m->avail, i);
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        for (size_t r = 0; r < it->requires_count; r++) {
+            const int j = find_linear(reg, it->requires[r]);
+            if (j < 0) {
+                snprintf(err, err_len, "%s requires unknown item %s", it->id, it->requires[r]);
+                return -1;
+            }
+            cfg_bits_set(&m->req[i], (size_t)j);
+            cfg_bits_set(&m->req_col[j], i);
+        }
+        for (size_t j = 0; j < n; j++) {
+            if (j == i) continue;
+            const cfg_item_t *jt = &reg->items[j];
+            /* items unusable on this revision claim no pins */
+            const bool both = cfg_bits_test(&m->avail, i) && cfg_bits_test(&m->avail, j);
+            if ((both && (it->pins[rank] & jt->pins[rank]) != 0) ||
+                lists_id(it->conflicts, it->conflicts_count, jt->id) ||
+                lists_id(jt->conflicts, jt->conflicts_count, it->id)) {
+                cfg_bits_set(&m->conf[i], j);
+            }
+        }
+    }
+
+    /* closure by depth-first expansion */
+    for (size_t i = 0; i < n; i++) {
+        size_t stack[CFG_MAX_ITEMS];
+        size_t sp = 0;
+        cfg_bits_set(&m->closure[i], i);
+        stack[sp++] = i;
+        while (sp) {
+            const size_t k = stack[--sp];
+            for (size_t j = cfg_bits_next(&m->req[k], 0); j < CFG_MAX_ITEMS; j = cfg_bits_next(&m->req[k], j + 1)) {
+                if (cfg_bits_test(&m->closure[i], j)) continue;
+                cfg_bits_set(&m->closure[i], j);
+                stack[sp++] = j;
+            }
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t k = 0; k < n; k++) {
+            if (k != i && cfg_bits_test(&m->closure[k], i)) cfg_bits_set(&m->users[i], k);
+        }
+    }
+
+    /* groups: compare against each group's first member; swaps compose, so this is an equivalence */
+    size_t group_of[CFG_MAX_ITEMS];
+    size_t rep[CFG_MAX_ITEMS];
+    size_t size[CFG_MAX_ITEMS] = {0};
+    for (size_t i = 0; i < n; i++) {
+        size_t g = m->group_count;
+        if (symmetry) {
+            for (size_t k = 0; k < m->group_count; k++) {
+                if (interchangeable(m, rep[k], i)) {
+                    g = k;
+                    break;
+                }
+            }
+        }
+        if (g == m->group_count) rep[m->group_count++] = i;
+        group_of[i] = g;
+        size[g]++;
+    }
+    for (size_t g = 0; g < m->group_count; g++) m->group_start[g + 1] = m->group_start[g] + size[g];
+    size_t fill[CFG_MAX_ITEMS];
+    memcpy(fill, m->group_start, m->group_count * sizeof(size_t));
+    for (size_t i = 0; i < n; i++) {
+        const size_t g = group_of[i];
+        m->group_items[fill[g]++] = (uint16_t)i;
+        cfg_bits_set(&m->group_mask[g], i);
+    }
+    return 0;
+}
+
+static bool ref_valid(const ref_model_t *m, const cfg_bits_t *s) {
+    if (!cfg_bits_subset(s, &m->avail)) return false;
+    for (size_t i = cfg_bits_next(s, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(s, i + 1)) {
+        if (!cfg_bits_subset(&m->req[i], s)) return false;
+        if (cfg_bits_intersects(&m->conf[i], s)) return false;
+    }
+    return true;
+}
+
+/* Each group's enabled members moved to the front of the group */
+static cfg_bits_t canonical(const ref_model_t *m, const cfg_bits_t *s) {
+    cfg_bits_t r = *s;
+    for (size_t g = 0; g < m->group_count; g++) {
+        const size_t a = m->group_start[g];
+        const size_t b = m->group_start[g + 1];
+        if (b - a < 2) continue;
+        const cfg_bits_t in = cfg_bits_and(s, &m->group_mask[g]);
+        const size_t c = cfg_bits_count(&in);
+        r = cfg_bits_andnot(&r, &m->group_mask[g]);
+        for (size_t k = 0; k < c; k++) cfg_bits_set(&r, m->group_items[a + k]);
+    }
+    return r;
+}
+
+static double choose(size_t n, size_t k) {
+    double r = 1.0;
+    for (size_t i = 1; i <= k; i++) r = r * (double)(n - k + i) / (double)i;
+    return r;
+}
+
+/* Number of concrete states in the orbit of a canonical state */
+static double orbit_size(const ref_model_t *m, const cfg_bits_t *s) {
+    double r = 1.0;
+    for (size_t g = 0; g < m->group_count; g++) {
+        const size_t sz = m->group_start[g + 1] - m->group_start[g];
+        if (sz < 2) continue;
+        const cfg_bits_t in = cfg_bits_and(s, &m->group_mask[g]);
+        r *= choose(sz, cfg_bits_count(&in));
+    }
+    return r;
+}
+
+/* ---- violation reporting ---- */
+
+static atomic_size_t s_violations;
+static pthread_mutex_t s_report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void format_state(const ref_model_t *m, const cfg_bits_t *s, char *buf, size_t len) {
+    size_t off = 0;
+    buf[0] = 0;
+    for (size_t i = cfg_bits_next(s, 0); i < CFG_MAX_ITEMS && off < len; i = cfg_bits_next(s, i + 1)) {
+        off += (size_t)snprintf(buf + off, len - off, "%s%s", off ? "," : "", m->reg->items[i].id);
+    }
+    if (off == 0) snprintf(buf, len, "(none)");
+}
+
+static void violation(const ref_model_t *m, const char *fmt, const char *a, const char *b, const cfg_bits_t *s) {
+    const size_t nth = atomic_fetch_add(&s_violations, 1);
+    if (nth >= VERIFY_MAX_REPORTS) return;
+    char st[512] = "";
+    if (s) format_state(m, s, st, sizeof(st));
+    pthread_mutex_lock(&s_report_lock);
+    fprintf(stderr, "VIOLATION rev=%s: ", get_device_rev_str(m->rev));
+    fprintf(stderr, fmt, a ? a : "", b ? b : "");
+    if (s) fprintf(stderr, " [state: %s]", st);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&s_report_lock);
+}
+
+/* Registry masks and cfg_item_is_available against the reference */
+static void check_masks(const ref_model_t *m) {
+    const cfg_registry_t *reg = m->reg;
+    for (size_t i = 0; i < m->n; i++) {
+        const char *id = reg->items[i].id;
+        const bool avail = cfg_bits_test(&m->avail, i);
+        if (cfg_item_is_available(&reg->items[i], m->rev) != avail) {
+            violation(m, "cfg_item_is_available(%s) disagrees with the revision limits%s", id, "", NULL);
+        }
+        if (cfg_bits_test(&reg->avail_mask[m->rank], i) != avail) {
+            violation(m, "avail_mask bit of %s is wrong%s", id, "", NULL);
+        }
+        if (!cfg_bits_equal(&reg->requires_mask[i], &m->req[i])) {
+            violation(m, "requires_mask of %s is wrong%s", id, "", NULL);
+        }
+        cfg_bits_t closure = m->closure[i];
+        cfg_bits_clear(&closure, i);
+        if (!cfg_bits_equal(&reg->requires_closure[i], &closure)) {
+            violation(m, "requires_closure of %s is wrong%s", id, "", NULL);
+        }
+        if (!cfg_bits_equal(&reg->dependents[i], &m->users[i])) {
+            violation(m, "dependents of %s is wrong%s", id, "", NULL);
+        }
+        if (!cfg_bits_equal(cfg_registry_conflicts(reg, m->rank, i), &m->conf[i])) {
+            violation(m, "conflicts_mask of %s is wrong%s", id, "", NULL);
+        }
+    }
+}
+
+/* ---- toggle checking ---- */
+
+typedef enum {
+    ANSWER_YES = 0,
+    ANSWER_NO,
+    ANSWER_NONE, /* confirm == NULL */
+    ANSWER_COUNT,
+} answer_t;
+
+static const char *const ANSWER_NAMES[ANSWER_COUNT] = {"yes", "no", "no-callback"};
+
+static int confirm_yes(const char *title, const char *prompt) {
+    (void)title;
+    (void)prompt;
+    return 0;
+}
+
+static int confirm_no(const char *title, const char *prompt) {
+    (void)title;
+    (void)prompt;
+    return 1;
+}
+
+/* Expected result of toggling x in s; *out is the expected state when 0 is returned */
+static int expect_toggle(const ref_model_t *m, const cfg_bits_t *s, size_t x, answer_t ans, cfg_bits_t *out) {
+    *out = *s;
+    if (!cfg_bits_test(s, x)) {
+        const cfg_bits_t *need = &m->closure[x];
+        cfg_bits_t forbidden = {{0}};
+        for (size_t k = cfg_bits_next(need, 0); k < CFG_MAX_ITEMS; k = cfg_bits_next(need, k + 1)) {
+            cfg_bits_or_into(&forbidden, &m->conf[k]);
+        }
+        if (!cfg_bits_subset(need, &m->avail) || cfg_bits_intersects(need, &forbidden)) return -2;
+        if (ans == ANSWER_NO) return -4;
+
+        const cfg_bits_t hits = cfg_bits_and(s, &forbidden);
+        if (cfg_bits_any(&hits) && ans == ANSWER_NONE) return -3;
+        cfg_bits_t removed = hits;
+        for (size_t c = cfg_bits_next(&hits, 0); c < CFG_MAX_ITEMS; c = cfg_bits_next(&hits, c + 1)) {
+            cfg_bits_or_into(&removed, &m->users[c]);
+        }
+        *out = cfg_bits_andnot(s, &removed);
+        cfg_bits_or_into(out, need);
+        return 0;
+    }
+
+    const cfg_bits_t users = cfg_bits_and(s, &m->users[x]);
+    if (cfg_bits_any(&users)) {
+        if (ans == ANSWER_NONE) return -3;
+        if (ans == ANSWER_NO) return -4;
+    }
+    *out = cfg_bits_andnot(s, &users);
+    cfg_bits_clear(out, x);
+    return 0;
+}
+
+/* Runs the real toggle and compares; returns true and the new state if it succeeded */
+static bool check_toggle(const ref_model_t *m, const cfg_bits_t *s, size_t x, answer_t ans, cfg_bits_t *next) {
+    static int (*const CONFIRM[ANSWER_COUNT])(const char *, const char *) = {confirm_yes, confirm_no, NULL};
+
+    cfg_state_t st;
+    memset(&st, 0, sizeof(st));
+    st.reg = m->reg;
+    st.enabled = *s;
+    const int rc = cfg_state_toggle(&st, x, m->rev, CONFIRM[ans]);
+
+    cfg_bits_t want;
+    const int want_rc = expect_toggle(m, s, x, ans, &want);
+    const bool ok = (rc == want_rc) && (rc != 0 ? cfg_bits_equal(&st.enabled, s)
+                                                : cfg_bits_equal(&st.enabled, &want) && ref_valid(m, &st.enabled));
+    if (ok) {
+        if (rc != 0) return false;
+        *next = st.enabled;
+        return true;
+    }
+
+    /* slow path: say what went wrong */
+    char what[96];
+    snprintf(what, sizeof(what), "%s %s (answer %s)", cfg_bits_test(s, x) ? "disable" : "enable",
+             m->reg->items[x].id, ANSWER_NAMES[ans]);
+    if (rc != want_rc) {
+        char codes[64];
+        snprintf(codes, sizeof(codes), "returned %d, expected %d", rc, want_rc);
+        violation(m, "%s %s", what, codes, s);
+        return false;
+    }
+    if (rc != 0) {
+        if (!cfg_bits_equal(&st.enabled, s)) violation(m, "%s was refused but changed the state%s", what, "", s);
+        return false;
+    }
+    if (!cfg_bits_equal(&st.enabled, &want)) {
+        char got[512];
+        format_state(m, &st.enabled, got, sizeof(got));
+        violation(m, "%s produced %s", what, got, s);
+        return false;
+    }
+    violation(m, "%s produced an invalid state%s", what, "", s);
+    return false;
+}
+
+/* ---- state set ---- */
+
+typedef struct {
+    cfg_bits_t *v;
+    size_t n;
+    size_t cap;
+} bits_vec_t;
+
+static int vec_push(bits_vec_t *a, const cfg_bits_t *b) {
+    if (a->n == a->cap) {
+        const size_t cap = a->cap ? a->cap * 2 : 256;
+        cfg_bits_t *nv = realloc(a->v, cap * sizeof(cfg_bits_t));
+        if (!nv) return -1;
+        a->v = nv;
+        a->cap = cap;
+    }
+    a->v[a->n++] = *b;
+    return 0;
+}
+
+typedef struct {
+    cfg_bits_t *keys;
+    uint8_t *used;
+    size_t cap; /* power of two */
+    size_t n;
+} bits_set_t;
+
+static uint64_t bits_hash(const cfg_bits_t *b) {
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) {
+        h ^= b->w[k];
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+    }
+    return h;
+}
+
+static int set_grow(bits_set_t *s) {
+    const size_t cap = s->cap ? s->cap * 2 : 1024;
+    cfg_bits_t *keys = malloc(cap * sizeof(cfg_bits_t));
+    uint8_t *used = calloc(cap, 1);
+    if (!keys || !used) {
+        free(keys);
+        free(used);
+        return -1;
+    }
+    for (size_t i = 0; i < s->cap; i++) {
+        if (!s->used[i]) continue;
+        size_t h = (size_t)bits_hash(&s->keys[i]) & (cap - 1);
+        while (used[h]) h = (h + 1) & (cap - 1);
+        used[h] = 1;
+        keys[h] = s->keys[i];
+    }
+    free(s->keys);
+    free(s->used);
+    s->keys = keys;
+    s->used = used;
+    s->cap = cap;
+    return 0;
+}
+
+/* 1 if inserted, 0 if already present, -1 on allocation failure */
+static int set_insert(bits_set_t *s, const cfg_bits_t *b) {
+    if ((s->n + 1) * 2 > s->cap && set_grow(s) != 0) return -1;
+    size_t h = (size_t)bits_hash(b) & (s->cap - 1);
+    while (s->used[h]) {
+        if (cfg_bits_equal(&s->keys[h], b)) return 0;
+        h = (h + 1) & (s->cap - 1);
+    }
+    s->used[h] = 1;
+    s->keys[h] = *b;
+    s->n++;
+    return 1;
+}
+
+static void set_free(bits_set_t *s) {
+    free(s->keys);
+    free(s->used);
+    memset(s, 0, sizeof(*s));
+}
+
+/* ---- reachability walk ---- */
+
+#define WALK_CHUNK 64
+
+typedef struct {
+    const ref_model_t *m;
+    const bits_vec_t *frontier;
+    atomic_size_t next;
+} walk_level_t;
+
+typedef struct {
+    walk_level_t *level;
+    bits_vec_t out;
+    uint64_t transitions;
+    bool oom;
+} walk_worker_t;
+
+static void walk_state(walk_worker_t *w, const cfg_bits_t *s) {
+    const ref_model_t *m = w->level->m;
+    /* within a group, toggling any enabled (or any disabled) member leads to the same orbit */
+    for (size_t g = 0; g < m->group_count; g++) {
+        const size_t a = m->group_start[g];
+        const size_t b = m->group_start[g + 1];
+        const cfg_bits_t in = cfg_bits_and(s, &m->group_mask[g]);
+        const size_t c = cfg_bits_count(&in);
+        size_t picks[2];
+        size_t npicks = 0;
+        if (c > 0) picks[npicks++] = m->group_items[a];
+        if (a + c < b) picks[npicks++] = m->group_items[a + c];
+
+        for (size_t p = 0; p < npicks; p++) {
+            for (int ans = 0; ans < ANSWER_COUNT; ans++) {
+                cfg_bits_t next;
+                w->transitions++;
+                if (!check_toggle(m, s, picks[p], (answer_t)ans, &next)) continue;
+                const cfg_bits_t canon = canonical(m, &next);
+                if (cfg_bits_equal(&canon, s)) continue;
+                if (vec_push(&w->out, &canon) != 0) w->oom = true;
+            }
+        }
+    }
+}
+
+static void *walk_worker(void *arg) {
+    walk_worker_t *w = arg;
+    const bits_vec_t *f = w->level->frontier;
+    for (;;) {
+        const size_t i0 = atomic_fetch_add(&w->level->next, WALK_CHUNK);
+        if (i0 >= f->n) break;
+        const size_t i1 = (i0 + WALK_CHUNK < f->n) ? i0 + WALK_CHUNK : f->n;
+        for (size_t i = i0; i < i1; i++) walk_state(w, &f->v[i]);
+    }
+    return NULL;
+}
+
+typedef struct {
+    size_t canonical;
+    double states;
+    uint64_t transitions;
+    bool truncated;
+} walk_result_t;
+
+static int walk(const ref_model_t *m, long jobs, size_t max_states, bits_set_t *seen, walk_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    walk_worker_t *workers = calloc((size_t)jobs, sizeof(walk_worker_t));
+    pthread_t *threads = calloc((size_t)jobs, sizeof(pthread_t));
+    bits_vec_t frontier = {0};
+    const cfg_bits_t empty = {{0}};
+    int ret = -1;
+    if (!workers || !threads || vec_push(&frontier, &empty) != 0 || set_insert(seen, &empty) < 0) goto out;
+    res->states = 1.0;
+
+    while (frontier.n) {
+        walk_level_t level = {.m = m, .frontier = &frontier};
+        atomic_init(&level.next, 0);
+        long started = 0;
+        for (long t = 0; t < jobs; t++) {
+            workers[t].level = &level;
+            workers[t].out.n = 0;
+            if (pthread_create(&threads[t], NULL, walk_worker, &workers[t]) != 0) break;
+            started++;
+        }
+        if (started == 0) goto out;
+        for (long t = 0; t < started; t++) pthread_join(threads[t], NULL);
+
+        /* merge in thread order: deterministic counts, any thread count */
+        frontier.n = 0;
+        for (long t = 0; t < started; t++) {
+            walk_worker_t *w = &workers[t];
+            res->transitions += w->transitions;
+            w->transitions = 0;
+            if (w->oom) goto out;
+            for (size_t i = 0; i < w->out.n; i++) {
+                const int r = set_insert(seen, &w->out.v[i]);
+                if (r < 0) goto out;
+                if (r == 0) continue;
+                res->states += orbit_size(m, &w->out.v[i]);
+                if (vec_push(&frontier, &w->out.v[i]) != 0) goto out;
+            }
+        }
+        if (seen->n > max_states) {
+            res->truncated = true;
+            break;
+        }
+    }
+    res->canonical = seen->n;
+    ret = 0;
+
+out:
+    for (long t = 0; workers && t < jobs; t++) free(workers[t].out.v);
+    free(workers);
+    free(threads);
+    free(frontier.v);
+    return ret;
+}
+
+/* ---- valid state enumeration ---- */
+
+typedef struct {
+    const ref_model_t *m;
+    const bits_set_t *seen; /* reachable canonical states */
+    size_t canonical;
+    double states;
+    size_t unreachable;
+    size_t max_states;
+    bool truncated;
+} enum_ctx_t;
+
+static void enum_valid(enum_ctx_t *e, size_t g, const cfg_bits_t *s, const cfg_bits_t *forbidden, double orbit) {
+    const ref_model_t *m = e->m;
+    if (e->canonical > e->max_states) {
+        e->truncated = true;
+        return;
+    }
+    if (g == m->group_count) {
+        for (size_t i = cfg_bits_next(s, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(s, i + 1)) {
+            if (!cfg_bits_subset(&m->req[i], s)) return;
+        }
+        e->canonical++;
+        e->states += orbit;
+        /* lookup only: the walk is finished */
+        size_t h = (size_t)bits_hash(s) & (e->seen->cap - 1);
+        bool found = false;
+        while (e->seen->used[h]) {
+            if (cfg_bits_equal(&e->seen->keys[h], s)) {
+                found = true;
+                break;
+            }
+            h = (h + 1) & (e->seen->cap - 1);
+        }
+        if (!found && e->unreachable++ == 0) violation(m, "valid state is not reachable by toggling%s%s", "", "", s);
+        return;
+    }
+
+    const size_t a = m->group_start[g];
+    const size_t sz = m->group_start[g + 1] - a;
+    enum_valid(e, g + 1, s, forbidden, orbit);
+
+    cfg_bits_t cur = *s;
+    cfg_bits_t f = *forbidden;
+    for (size_t c = 1; c <= sz; c++) {
+        const size_t x = m->group_items[a + c - 1];
+        if (!cfg_bits_test(&m->avail, x) || cfg_bits_test(&f, x)) break;
+        cfg_bits_set(&cur, x);
+        cfg_bits_or_into(&f, &m->conf[x]);
+        enum_valid(e, g + 1, &cur, &f, orbit * choose(sz, c));
+    }
+}
+
+/* ---- synthetic registries ---- */
+
+static uint32_t rng_next(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+typedef struct {
+    cfg_registry_t reg;
+    cfg_item_t *items;
+    char (*ids)[16];
+    const char **refs; /* one requires and one conflicts slot per item */
+    uint16_t *slots;
+    cfg_bits_t *masks;
+} synth_t;
+
+static int synth_build(synth_t *sy, size_t n, uint32_t seed) {
+    memset(sy, 0, sizeof(*sy));
+    uint32_t rs = seed ? seed : 1;
+    sy->items = calloc(n, sizeof(cfg_item_t));
+    sy->ids = calloc(n, sizeof(*sy->ids));
+    sy->refs = calloc(2 * n, sizeof(char *));
+    const uint32_t cap = cfg_registry_hash_capacity(n);
+    sy->slots = malloc(cap * sizeof(uint16_t));
+    sy->masks = calloc(CFG_MASK_STORAGE(n), sizeof(cfg_bits_t));
+    if (!sy->items || !sy->ids || !sy->refs || !sy->slots || !sy->masks) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        cfg_item_t *it = &sy->items[i];
+        snprintf(sy->ids[i], sizeof(sy->ids[i]), "syn%zu", i);
+        if (i > 0 && rng_next(&rs) % 4 == 0) {
+            /* copy of the previous item: gives the verifier symmetry to exploit */
+            *it = sy->items[i - 1];
+        } else {
+            it->min_rev_rank = (rng_next(&rs) % 8 == 0) ? 2 : -1;
+            it->max_rev_rank = (rng_next(&rs) % 8 == 0) ? 1 : -1;
+            if (rng_next(&rs) % 3 != 0) {
+                cfg_pins_t pre = 0;
+                const unsigned k = 1 + rng_next(&rs) % 3;
+                for (unsigned p = 0; p < k; p++) pre |= (cfg_pins_t)1 << (rng_next(&rs) % CFG_PIN_COUNT);
+                cfg_pins_t post = (rng_next(&rs) % 4 == 0) ? (cfg_pins_t)1 << (rng_next(&rs) % CFG_PIN_COUNT) : pre;
+                const cfg_pins_t pins[CFG_REV_RANKS] = CFG_PINS_BY_REV(pre, post);
+                memcpy(it->pins, pins, sizeof(pins));
+            }
+            if (i > 0 && rng_next(&rs) % 4 == 0) {
+                sy->refs[2 * i] = sy->ids[rng_next(&rs) % i];
+                it->requires = &sy->refs[2 * i];
+                it->requires_count = 1;
+            }
+            if (i > 0 && rng_next(&rs) % 16 == 0) {
+                sy->refs[2 * i + 1] = sy->ids[rng_next(&rs) % i];
+                it->conflicts = &sy->refs[2 * i + 1];
+                it->conflicts_count = 1;
+            }
+        }
+        it->id = sy->ids[i];
+        it->title = it->id;
+        it->cat = (i % 2) ? CFG_CAT_EXT : CFG_CAT_INTERFACE;
+    }
+
+    sy->reg.items = sy->items;
+    sy->reg.count = n;
+    if (cfg_registry_build_hash(&sy->reg, sy->slots, cap) != 0) return -1;
+    return cfg_registry_build_masks(&sy->reg, sy->masks);
+}
+
+static void synth_free(synth_t *sy) {
+    free(sy->items);
+    free(sy->ids);
+    free(sy->refs);
+    free(sy->slots);
+    free(sy->masks);
+}
+
+/* ---- main ---- */
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: srgn_verify [--jobs N] [--rev REV] [--synthetic N] [--seed S]\n"
+            "                   [--max-states N] [--no-symmetry]\n");
+}
+
+int main(int argc, char **argv) {
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    long synthetic = 0;
+    uint32_t seed = 1;
+    size_t max_states = (size_t)1 << 22;
+    bool symmetry = true;
+    bool have_rev = false;
+    device_rev_t only_rev = DEVICE_REV_EPASS_0_2;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--jobs") == 0 && (i + 1) < argc) {
+            jobs = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rev") == 0 && (i + 1) < argc) {
+            if (device_rev_from_str(argv[++i], &only_rev) != 0) {
+                fprintf(stderr, "srgn_verify: unknown revision %s\n", argv[i]);
+                return 1;
+            }
+            have_rev = true;
+        } else if (strcmp(argv[i], "--synthetic") == 0 && (i + 1) < argc) {
+            synthetic = strtol(argv[++i], NULL, 10);
+            if (synthetic < 1 || synthetic > CFG_MAX_ITEMS) {
+                fprintf(stderr, "srgn_verify: --synthetic takes 1..%d\n", CFG_MAX_ITEMS);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && (i + 1) < argc) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-states") == 0 && (i + 1) < argc) {
+            max_states = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-symmetry") == 0) {
+            symmetry = false;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (jobs < 1) jobs = 1;
+
+    synth_t sy;
+    const cfg_registry_t *reg = NULL;
+    if (synthetic) {
+        if (synth_build(&sy, (size_t)synthetic, seed) != 0) {
+            fprintf(stderr, "srgn_verify: failed to build synthetic registry\n");
+            synth_free(&sy);
+            return 2;
+        }
+        reg = &sy.reg;
+    } else {
+        reg = cfg_registry_get();
+        if (!reg) {
+            fprintf(stderr, "srgn_verify: built-in registry is inconsistent\n");
+            return 2;
+        }
+    }
+
+    ref_model_t *m = malloc(sizeof(*m));
+    if (!m) return 2;
+
+    int ret = 0;
+    const double t_all = now_ms();
+    for (int rank = 0; rank < CFG_REV_RANKS; rank++) {
+        if (have_rev && device_rev_rank(only_rev) != rank) continue;
+        char err[256];
+        if (ref_build(m, reg, rank, symmetry, err, sizeof(err)) != 0) {
+            fprintf(stderr, "srgn_verify: %s\n", err);
+            ret = 2;
+            break;
+        }
+        const size_t v0 = atomic_load(&s_violations);
+        check_masks(m);
+
+        bits_set_t seen = {0};
+        walk_result_t wr;
+        const double t0 = now_ms();
+        if (walk(m, jobs, max_states, &seen, &wr) != 0) {
+            fprintf(stderr, "srgn_verify: out of memory\n");
+            set_free(&seen);
+            ret = 2;
+            break;
+        }
+        const double t1 = now_ms();
+
+        enum_ctx_t e = {.m = m, .seen = &seen, .max_states = max_states};
+        const cfg_bits_t empty = {{0}};
+        if (!wr.truncated) enum_valid(&e, 0, &empty, &empty, 1.0);
+        const double t2 = now_ms();
+
+        printf("rev=%s items=%zu groups=%zu reachable=%zu reachable_states=%.0f valid=%zu valid_states=%.0f "
+               "unreachable=%zu transitions=%llu violations=%zu walk_ms=%.1f enum_ms=%.1f%s\n",
+               get_device_rev_str(m->rev), m->n, m->group_count, wr.canonical, wr.states, e.canonical, e.states,
+               e.unreachable, (unsigned long long)wr.transitions, atomic_load(&s_violations) - v0, t1 - t0, t2 - t1,
+               (wr.truncated || e.truncated) ? " truncated" : "");
+        fflush(stdout);
+        set_free(&seen);
+        if ((wr.truncated || e.truncated) && ret == 0) ret = 2;
+    }
+
+    const size_t violations = atomic_load(&s_violations);
+    printf("violations=%zu workers=%ld symmetry=%s wall_ms=%.1f\n", violations, jobs, symmetry ? "on" : "off",
+           now_ms() - t_all);
+    if (violations > VERIFY_MAX_REPORTS) fprintf(stderr, "srgn_verify: %zu more violations not shown\n", violations - VERIFY_MAX_REPORTS);
+
+    free(m);
+    if (synthetic) synth_free(&sy);
+    if (violations) return 3;
+    return ret;
+}
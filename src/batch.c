@@ -0,0 +1,353 @@
+#define _GNU_SOURCE
+#include "batch.h"
+
+#include <ftw.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config_profile.h"
+#include "config_registry.h"
+#include "config_state.h"
+#include "filter.h"
+#include "overlay_pins.h"
+#include "uenv.h"
+
+typedef enum {
+    BATCH_OK = 0,
+    BATCH_CHANGED,
+    BATCH_INVALID,
+    BATCH_ERROR,
+} batch_status_t;
+
+static const char *const BATCH_STATUS_STR[] = {"ok", "changed", "invalid", "error"};
+
+typedef struct {
+    char *path;
+    batch_status_t status;
+    double ms;
+    char detail[256]; /* as large as the err buffers it is copied from */
+    size_t view;      /* index into batch_job_t views */
+} batch_file_t;
+
+typedef struct {
+    filter_opts_t opts;
+    bool check;
+    batch_file_t *files;
+    size_t file_count;
+    overlay_view_t *views; /* one per overlay directory, read-only once the workers run */
+    size_t view_count;
+    atomic_size_t next;
+} batch_job_t;
+
+/* nftw() has no user pointer; the walk runs single-threaded before the pool starts */
+static batch_file_t **s_walk_files;
+static size_t *s_walk_count;
+static const char *s_walk_name;
+static int s_walk_oom;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void batch_usage(void) {
+    fprintf(stderr,
+            "usage: srgn_config --batch --rev <0.2|0.3|0.4|0.5|0.6> [--profile NAME|CODE] [--target ID,ID...]\n"
+            "                   [--enable ID]... [--disable ID]... [--force] [--check] [--jobs N] [--name uEnv.txt] [--list FILE|-] [PATH]...\n");
+}
+
+static int files_push(batch_file_t **v, size_t *n, const char *path) {
+    batch_file_t *nv = realloc(*v, (*n + 1) * sizeof(batch_file_t));
+    if (!nv) return -1;
+    *v = nv;
+    memset(&nv[*n], 0, sizeof(nv[*n]));
+    nv[*n].path = strdup(path);
+    if (!nv[*n].path) return -1;
+    *n = *n + 1;
+    return 0;
+}
+
+static int walk_cb(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+    (void)sb;
+    if (typeflag != FTW_F) return 0;
+    if (strcmp(fpath + ftwbuf->base, s_walk_name) != 0) return 0;
+    if (files_push(s_walk_files, s_walk_count, fpath) != 0) {
+        s_walk_oom = 1;
+        return 1;
+    }
+    return 0;
+}
+
+static int cmp_files(const void *a, const void *b) {
+    return strcmp(((const batch_file_t *)a)->path, ((const batch_file_t *)b)->path);
+}
+
+static int collect_path(batch_file_t **v, size_t *n, const char *path, const char *name) {
+    struct stat sb;
+    if (stat(path, &sb) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (!S_ISDIR(sb.st_mode)) return files_push(v, n, path);
+
+    const size_t first = *n;
+    s_walk_files = v;
+    s_walk_count = n;
+    s_walk_name = name;
+    s_walk_oom = 0;
+    if (nftw(path, walk_cb, 16, FTW_PHYS) != 0 || s_walk_oom) {
+        if (!s_walk_oom) perror(path);
+        return -1;
+    }
+    /* directory order is arbitrary; keep the report stable */
+    qsort(*v + first, *n - first, sizeof(batch_file_t), cmp_files);
+    return 0;
+}
+
+static int collect_list(batch_file_t **v, size_t *n, const char *list_path) {
+    FILE *fp = strcmp(list_path, "-") == 0 ? stdin : fopen(list_path, "r");
+    if (!fp) {
+        perror(list_path);
+        return -1;
+    }
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int ret = 0;
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = 0;
+        if (len == 0) continue;
+        if (files_push(v, n, line) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+    free(line);
+    if (fp != stdin) fclose(fp);
+    return ret;
+}
+
+/* Registry of every file, derived once per overlay directory before the
+ * workers start (most batches share one directory or have none) */
+static int open_views(batch_job_t *job) {
+    size_t last = 0;
+    for (size_t i = 0; i < job->file_count; i++) {
+        batch_file_t *f = &job->files[i];
+        char buf[512];
+        const char *dir = overlay_default_dir(f->path, buf, sizeof(buf));
+        size_t k = last;
+        if (k >= job->view_count || !job->views[k].overlays.dir || strcmp(job->views[k].overlays.dir, dir) != 0) {
+            for (k = 0; k < job->view_count; k++) {
+                if (job->views[k].overlays.dir && strcmp(job->views[k].overlays.dir, dir) == 0) break;
+            }
+        }
+        if (k == job->view_count) {
+            overlay_view_t *nv = realloc(job->views, (job->view_count + 1) * sizeof(overlay_view_t));
+            if (!nv) return -1;
+            job->views = nv;
+            if (overlay_view_open(&nv[k], f->path, job->opts.rev) != 0) return -1;
+            job->view_count++;
+        }
+        f->view = last = k;
+    }
+    return 0;
+}
+
+static void process_file(const batch_job_t *job, batch_file_t *f) {
+    const double t0 = now_ms();
+    char err[256];
+    uenv_file_t u;
+    cfg_state_t st;
+    bool changed = false;
+
+    f->status = BATCH_OK;
+    if (uenv_load(f->path, &u, err, sizeof(err)) != 0) {
+        f->status = BATCH_ERROR;
+        snprintf(f->detail, sizeof(f->detail), "%s", err);
+        goto out;
+    }
+    if (cfg_state_init_from_uenv(&st, overlay_view_registry(&job->views[f->view]), &u, job->opts.rev) != 0) {
+        f->status = BATCH_ERROR;
+        snprintf(f->detail, sizeof(f->detail), "failed to initialize config state");
+        uenv_free(&u);
+        goto out;
+    }
+
+    if (filter_apply_ops(&st, &job->opts, job->opts.force ? filter_confirm_force : filter_confirm_strict,
+                         &changed, err, sizeof(err)) != 0) {
+        f->status = BATCH_INVALID;
+        snprintf(f->detail, sizeof(f->detail), "%s", err);
+    } else if (cfg_state_validate(&st, job->opts.rev, err, sizeof(err)) != 0) {
+        f->status = BATCH_INVALID;
+        snprintf(f->detail, sizeof(f->detail), "%s", err);
+    } else if (changed) {
+        f->status = BATCH_CHANGED;
+        if (job->check) {
+            snprintf(f->detail, sizeof(f->detail), "not written (--check)");
+        } else {
+            cfg_lines_t lines = {0};
+            if (cfg_state_render(&st, &lines) != 0) {
+                f->status = BATCH_ERROR;
+                snprintf(f->detail, sizeof(f->detail), "out of memory");
+            } else if (uenv_write_preserve(f->path, &u, lines.interface_line, lines.ext_line, err, sizeof(err)) != 0) {
+                f->status = BATCH_ERROR;
+                snprintf(f->detail, sizeof(f->detail), "%s", err);
+            }
+            cfg_lines_free(&lines);
+        }
+    }
+
+    cfg_state_free(&st);
+    uenv_free(&u);
+out:
+    f->ms = now_ms() - t0;
+}
+
+static void *batch_worker(void *arg) {
+    batch_job_t *job = arg;
+    for (;;) {
+        const size_t i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->file_count) break;
+        process_file(job, &job->files[i]);
+    }
+    return NULL;
+}
+
+int batch_requested(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0) return 1;
+    }
+    return 0;
+}
+
+int batch_run(int argc, char **argv) {
+    batch_job_t job = {0};
+    cfg_profile_t profile;
+    const char *name = "uEnv.txt";
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int ret = 0;
+
+    job.opts.ops = calloc((size_t)argc, sizeof(filter_op_t));
+    if (!job.opts.ops) return 2;
+
+    /* first pass: options; second pass: paths (--name must be known before walking) */
+    for (int i = 1; i < argc; i++) {
+        const int r = filter_parse_opt(&job.opts, argc, argv, &i);
+        if (r < 0) {
+            ret = 1;
+            goto out;
+        }
+        if (r > 0) continue;
+        if (strcmp(argv[i], "--batch") == 0) {
+            continue;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            job.check = true;
+        } else if (strcmp(argv[i], "--jobs") == 0 && (i + 1) < argc) {
+            jobs = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--name") == 0 && (i + 1) < argc) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0 && (i + 1) < argc) {
+            i++;
+        } else if (argv[i][0] == '-') {
+            batch_usage();
+            ret = 1;
+            goto out;
+        }
+    }
+    if (filter_default_rev(&job.opts) != 0) {
+        batch_usage();
+        ret = 1;
+        goto out;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rev") == 0 || strcmp(argv[i], "--enable") == 0 ||
+            strcmp(argv[i], "--disable") == 0 || strcmp(argv[i], "--jobs") == 0 ||
+            strcmp(argv[i], "--name") == 0 || strcmp(argv[i], "--target") == 0 ||
+            strcmp(argv[i], "--profile") == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--list") == 0) {
+            if (collect_list(&job.files, &job.file_count, argv[++i]) != 0) {
+                ret = 2;
+                goto out;
+            }
+        } else if (argv[i][0] != '-') {
+            if (collect_path(&job.files, &job.file_count, argv[i], name) != 0) {
+                ret = 2;
+                goto out;
+            }
+        }
+    }
+
+    /* one disk read / decode for the whole run, and every file gets the same profile */
+    if (job.opts.profile) {
+        char err[256];
+        if (cfg_profile_resolve(job.opts.profile, &profile, err, sizeof(err)) != 0) {
+            fprintf(stderr, "srgn_config: %s\n", err);
+            ret = 1;
+            goto out;
+        }
+        job.opts.profile_resolved = &profile;
+    }
+
+    /* build lazily-initialized shared data before any worker touches it */
+    if (open_views(&job) != 0) {
+        fprintf(stderr, "srgn_config: failed to load the registry\n");
+        ret = 2;
+        goto out;
+    }
+
+    if (jobs < 1) jobs = 1;
+    if ((size_t)jobs > job.file_count) jobs = job.file_count ? (long)job.file_count : 1;
+    pthread_t *threads = calloc((size_t)jobs, sizeof(pthread_t));
+    if (!threads) {
+        ret = 2;
+        goto out;
+    }
+
+    const double t0 = now_ms();
+    long started = 0;
+    for (; started < jobs; started++) {
+        if (pthread_create(&threads[started], NULL, batch_worker, &job) != 0) break;
+    }
+    if (started == 0) batch_worker(&job);
+    for (long i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    const double wall = now_ms() - t0;
+    free(threads);
+
+    size_t counts[4] = {0};
+    double busy = 0;
+    printf("%-8s %10s  %s\n", "STATUS", "TIME(ms)", "FILE");
+    for (size_t i = 0; i < job.file_count; i++) {
+        const batch_file_t *f = &job.files[i];
+        counts[f->status]++;
+        busy += f->ms;
+        printf("%-8s %10.3f  %s%s%s\n", BATCH_STATUS_STR[f->status], f->ms, f->path,
+               f->detail[0] ? ": " : "", f->detail);
+    }
+    printf("files=%zu ok=%zu changed=%zu invalid=%zu error=%zu workers=%ld wall_ms=%.3f busy_ms=%.3f files_per_s=%.0f\n",
+           job.file_count, counts[BATCH_OK], counts[BATCH_CHANGED], counts[BATCH_INVALID], counts[BATCH_ERROR],
+           started ? started : 1, wall, busy, wall > 0 ? (double)job.file_count * 1e3 / wall : 0.0);
+
+    if (counts[BATCH_ERROR]) {
+        ret = 2;
+    } else if (counts[BATCH_INVALID]) {
+        ret = 3;
+    }
+
+out:
+    if (job.opts.profile_resolved) cfg_profile_free(&profile);
+    for (size_t i = 0; i < job.view_count; i++) overlay_view_free(&job.views[i]);
+    free(job.views);
+    for (size_t i = 0; i < job.file_count; i++) free(job.files[i].path);
+    free(job.files);
+    free(job.opts.ops);
+    return ret;
+}
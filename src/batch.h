@@ -0,0 +1,19 @@
+#pragma once
+
+/*
+ * Parallel batch processing of many uEnv files:
+ *   srgn_config --batch --rev <0.2..0.6> [--profile NAME|CODE] [--target ID,ID...]
+ *               [--enable ID]... [--disable ID]... [--force]
+ *               [--check] [--jobs N] [--name uEnv.txt] [--list FILE|-] [PATH]...
+ *
+ * PATH may be a file or a directory (searched recursively for --name).
+ * Every file is loaded, edited, validated against --rev and the overlays
+ * next to it (overlay_view_t) and, unless --check is given, written back
+ * with uenv_write_preserve. One worker per core.
+ * Without --rev the revision comes from $SRGN_DEVICE.
+ */
+
+int batch_requested(int argc, char **argv);
+
+/* Exit code: 0 all ok, 1 usage or an unusable --profile, 2 some files failed, 3 some files invalid */
+int batch_run(int argc, char **argv);
@@ -0,0 +1,88 @@
+#pragma once
+
+/*
+ * Fixed-width bitset indexed by registry item index.
+ * Used for the enabled set in cfg_state_t and for the per-item requirement /
+ * conflict masks the registry precomputes, so most checks are a few word ops.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CFG_MAX_ITEMS  256
+#define CFG_BITS_WORDS (CFG_MAX_ITEMS / 64)
+
+typedef struct {
+    uint64_t w[CFG_BITS_WORDS];
+} cfg_bits_t;
+
+static inline void cfg_bits_set(cfg_bits_t *b, size_t i) {
+    b->w[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void cfg_bits_clear(cfg_bits_t *b, size_t i) {
+    b->w[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+static inline bool cfg_bits_test(const cfg_bits_t *b, size_t i) {
+    return (b->w[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline bool cfg_bits_any(const cfg_bits_t *b) {
+    uint64_t acc = 0;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) acc |= b->w[k];
+    return acc != 0;
+}
+
+static inline bool cfg_bits_equal(const cfg_bits_t *a, const cfg_bits_t *b) {
+    uint64_t acc = 0;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) acc |= a->w[k] ^ b->w[k];
+    return acc == 0;
+}
+
+static inline bool cfg_bits_intersects(const cfg_bits_t *a, const cfg_bits_t *b) {
+    uint64_t acc = 0;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) acc |= a->w[k] & b->w[k];
+    return acc != 0;
+}
+
+/* true if every bit of a is also set in b */
+static inline bool cfg_bits_subset(const cfg_bits_t *a, const cfg_bits_t *b) {
+    uint64_t acc = 0;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) acc |= a->w[k] & ~b->w[k];
+    return acc == 0;
+}
+
+static inline cfg_bits_t cfg_bits_and(const cfg_bits_t *a, const cfg_bits_t *b) {
+    cfg_bits_t r;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) r.w[k] = a->w[k] & b->w[k];
+    return r;
+}
+
+static inline cfg_bits_t cfg_bits_andnot(const cfg_bits_t *a, const cfg_bits_t *b) {
+    cfg_bits_t r;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) r.w[k] = a->w[k] & ~b->w[k];
+    return r;
+}
+
+static inline void cfg_bits_or_into(cfg_bits_t *dst, const cfg_bits_t *src) {
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) dst->w[k] |= src->w[k];
+}
+
+static inline size_t cfg_bits_count(const cfg_bits_t *b) {
+    size_t n = 0;
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) n += (size_t)__builtin_popcountll(b->w[k]);
+    return n;
+}
+
+/* Index of the first set bit at or after i, or CFG_MAX_ITEMS.
+ * Iterate with: for (i = cfg_bits_next(b, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(b, i + 1)) */
+static inline size_t cfg_bits_next(const cfg_bits_t *b, size_t i) {
+    while (i < CFG_MAX_ITEMS) {
+        const uint64_t w = b->w[i >> 6] >> (i & 63);
+        if (w) return i + (size_t)__builtin_ctzll(w);
+        i = (i | 63) + 1;
+    }
+    return CFG_MAX_ITEMS;
+}
@@ -0,0 +1,119 @@
+#include "cfg_intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_registry.h"
+
+/* load factor <= 1/2 */
+static int grow_slots(cfg_intern_t *t, uint32_t want) {
+    uint32_t size = 8;
+    while (size < 2 * want) size <<= 1;
+    if (t->slots && size <= t->slot_mask + 1) return 0;
+
+    uint32_t *slots = malloc(size * sizeof(uint32_t));
+    if (!slots) return -1;
+    memset(slots, 0xFF, size * sizeof(uint32_t));
+    for (uint32_t h = 0; h < t->total; h++) {
+        uint32_t s = cfg_hash_id(t->arena + t->offs[h], 0) & (size - 1);
+        while (slots[s] != CFG_INTERN_NONE) s = (s + 1) & (size - 1);
+        slots[s] = h;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slot_mask = size - 1;
+    return 0;
+}
+
+static int grow_offs(cfg_intern_t *t, size_t want) {
+    if (want <= t->cap) return 0;
+    if (want >= CFG_INTERN_NONE) return -1;
+    size_t cap = t->cap ? t->cap : 8;
+    while (cap < want) cap *= 2;
+    uint32_t *offs = realloc(t->offs, cap * sizeof(uint32_t));
+    if (!offs) return -1;
+    t->offs = offs;
+    t->cap = (uint32_t)cap;
+    return 0;
+}
+
+static int grow_arena(cfg_intern_t *t, size_t want) {
+    if (want <= t->arena_cap) return 0;
+    if (want > UINT32_MAX) return -1; /* offsets are 32-bit */
+    size_t cap = t->arena_cap ? t->arena_cap : 256;
+    while (cap < want) cap *= 2;
+    char *arena = realloc(t->arena, cap);
+    if (!arena) return -1;
+    t->arena = arena;
+    t->arena_cap = cap;
+    return 0;
+}
+
+int cfg_intern_reserve(cfg_intern_t *t, size_t tokens, size_t bytes) {
+    if (!t) return -1;
+    if (grow_offs(t, t->total + tokens) != 0) return -1;
+    if (grow_arena(t, t->arena_len + bytes + tokens) != 0) return -1;
+    return grow_slots(t, (uint32_t)(t->total + tokens));
+}
+
+static uint32_t *find_slot(const cfg_intern_t *t, const char *s, uint32_t hash) {
+    uint32_t i = hash & t->slot_mask;
+    for (;;) {
+        const uint32_t h = t->slots[i];
+        if (h == CFG_INTERN_NONE || strcmp(t->arena + t->offs[h], s) == 0) return &t->slots[i];
+        i = (i + 1) & t->slot_mask;
+    }
+}
+
+uint32_t cfg_intern_find(const cfg_intern_t *t, const char *s) {
+    if (!t || !s || !t->slots) return CFG_INTERN_NONE;
+    const uint32_t h = *find_slot(t, s, cfg_hash_id(s, 0));
+    return h < t->count ? h : CFG_INTERN_NONE;
+}
+
+/* Forget the hidden handles for good; linear probing can't delete in place, so re-insert the rest */
+static void drop_hidden(cfg_intern_t *t) {
+    t->arena_len = t->offs[t->count];
+    t->total = t->count;
+    t->generation++;
+    memset(t->slots, 0xFF, ((size_t)t->slot_mask + 1) * sizeof(uint32_t));
+    for (uint32_t h = 0; h < t->count; h++) *find_slot(t, t->arena + t->offs[h], cfg_hash_id(t->arena + t->offs[h], 0)) = h;
+}
+
+uint32_t cfg_intern_add(cfg_intern_t *t, const char *s, int *added) {
+    if (added) *added = 0;
+    if (!t || !s) return CFG_INTERN_NONE;
+    if (grow_slots(t, t->total + 1) != 0) return CFG_INTERN_NONE;
+
+    const uint32_t hash = cfg_hash_id(s, 0);
+    uint32_t *slot = find_slot(t, s, hash);
+    if (*slot < t->count) return *slot;
+    if (t->total != t->count) {
+        drop_hidden(t);
+        slot = find_slot(t, s, hash);
+    }
+
+    const size_t len = strlen(s) + 1;
+    if (grow_offs(t, (size_t)t->count + 1) != 0 || grow_arena(t, t->arena_len + len) != 0) return CFG_INTERN_NONE;
+    memcpy(t->arena + t->arena_len, s, len);
+    t->offs[t->count] = (uint32_t)t->arena_len;
+    t->arena_len += len;
+    *slot = t->count; /* grow_slots above kept the slot array in place */
+    if (added) *added = 1;
+    t->total = t->count + 1;
+    return t->count++;
+}
+
+int cfg_intern_set_count(cfg_intern_t *t, uint32_t count) {
+    if (!t || count > t->total) return -1;
+    t->count = count;
+    return 0;
+}
+
+void cfg_intern_free(cfg_intern_t *t) {
+    if (!t) return;
+    free(t->arena);
+    free(t->offs);
+    free(t->slots);
+    memset(t, 0, sizeof(*t));
+}
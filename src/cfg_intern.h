@@ -0,0 +1,53 @@
+#pragma once
+
+/*
+ * Token interning table: each distinct string is stored once in an arena and
+ * named by a dense integer handle (0, 1, ... in insertion order). Lookup is one
+ * hash plus one compare, so deduplicating n tokens is O(n).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CFG_INTERN_NONE UINT32_MAX
+
+typedef struct {
+    char *arena;        /* NUL-terminated strings back to back */
+    size_t arena_len;
+    size_t arena_cap;
+    uint32_t *offs;     /* handle -> offset into arena */
+    uint32_t count;     /* visible handles */
+    uint32_t total;     /* [count, total) were hidden by cfg_intern_set_count and can come back */
+    uint32_t generation; /* bumped when hidden handles are dropped and their numbers reissued */
+    uint32_t cap;
+    uint32_t *slots;    /* open addressing, handle or CFG_INTERN_NONE */
+    uint32_t slot_mask;
+} cfg_intern_t;
+
+/* Reserve room for about `tokens` strings totalling `bytes` (without NULs) so
+ * filling the table up to that size allocates nothing more. Returns 0 or -1. */
+int cfg_intern_reserve(cfg_intern_t *t, size_t tokens, size_t bytes);
+
+/* Handle of s, adding it if new (*added tells which). Returns CFG_INTERN_NONE on OOM. */
+uint32_t cfg_intern_add(cfg_intern_t *t, const char *s, int *added);
+
+/* Handle of s, or CFG_INTERN_NONE if it is not (or no longer) visible */
+uint32_t cfg_intern_find(const cfg_intern_t *t, const char *s);
+
+static inline const char *cfg_intern_str(const cfg_intern_t *t, uint32_t h) {
+    return t->arena + t->offs[h];
+}
+
+/* Show only handles < count. Hidden handles keep their strings and can be
+ * shown again until the next cfg_intern_add of a new string drops them
+ * (which bumps generation: a count saved before then may name other strings).
+ * Returns 0, or -1 if count exceeds what the table holds. */
+int cfg_intern_set_count(cfg_intern_t *t, uint32_t count);
+
+/* Length without recomputing strlen: strings are packed back to back */
+static inline size_t cfg_intern_len(const cfg_intern_t *t, uint32_t h) {
+    const size_t end = (h + 1 < t->total) ? t->offs[h + 1] : t->arena_len;
+    return end - t->offs[h] - 1;
+}
+
+void cfg_intern_free(cfg_intern_t *t);
@@ -0,0 +1,366 @@
+#include "cli.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+#include "device.h"
+#include "filter.h"
+#include "overlay_pins.h"
+#include "uenv.h"
+
+typedef enum {
+    CMD_LIST,
+    CMD_GET,
+    CMD_ENABLE,
+    CMD_DISABLE,
+    CMD_VALIDATE,
+    CMD_DIFF,
+    CMD_APPLY_PROFILE,
+    CMD_COUNT,
+} cli_cmd_t;
+
+static const char *const CMD_NAMES[CMD_COUNT] = {
+    "list", "get", "enable", "disable", "validate", "diff", "apply-profile",
+};
+
+static const char *const CAT_NAMES[] = {"interface", "ext"};
+
+typedef struct {
+    cli_cmd_t cmd;
+    filter_opts_t o;
+    const char *uenv_path;
+    const char *device;
+    bool json;
+    bool dry_run;
+    const char **args;  /* positional arguments */
+    size_t arg_count;
+} cli_t;
+
+static void cli_usage(void) {
+    fprintf(stderr,
+            "usage: srgn_config list|validate [--json] [--uenv PATH] [--rev REV | --device REV[:SCREEN]]\n"
+            "       srgn_config get ID... [--json] [...]\n"
+            "       srgn_config enable|disable ID... [--force] [--dry-run] [--json] [...]\n"
+            "       srgn_config apply-profile NAME|CODE [--force] [--dry-run] [--json] [...]\n"
+            "       srgn_config diff [--profile NAME|CODE] [--target ID,ID...] [--enable ID]... [--disable ID]...\n"
+            "                        [--force] [--json] [...]\n");
+}
+
+static int find_cmd(const char *name) {
+    for (int i = 0; i < CMD_COUNT; i++) {
+        if (strcmp(name, CMD_NAMES[i]) == 0) return i;
+    }
+    return -1;
+}
+
+int cli_requested(int argc, char **argv) {
+    return argc > 1 && find_cmd(argv[1]) >= 0;
+}
+
+/* JSON string of the first len bytes of s (stops early at a NUL) */
+static void json_strn(const char *s, size_t len) {
+    putchar('"');
+    for (const char *end = s + len; s < end && *s; s++) {
+        const unsigned char ch = (unsigned char)*s;
+        if (ch == '"' || ch == '\\') {
+            printf("\\%c", ch);
+        } else if (ch == '\n') {
+            fputs("\\n", stdout);
+        } else if (ch < 0x20) {
+            printf("\\u%04x", ch);
+        } else {
+            putchar(ch);
+        }
+    }
+    putchar('"');
+}
+
+static void json_str(const char *s) {
+    json_strn(s, strlen(s));
+}
+
+/* "interface=a b\n" -> "a b" (the line without key and newline), of any length */
+static void json_line(const char *line) {
+    const char *eq = strchr(line, '=');
+    const char *v = eq ? eq + 1 : line;
+    json_strn(v, strcspn(v, "\n"));
+}
+
+static int parse_args(cli_t *c, int argc, char **argv) {
+    const char *env = getenv("SRGN_UENV_PATH");
+    c->uenv_path = (env && env[0]) ? env : "/boot/uEnv.txt";
+
+    for (int i = 2; i < argc; i++) {
+        const int r = filter_parse_opt(&c->o, argc, argv, &i);
+        if (r < 0) return -1;
+        if (r > 0) continue;
+        if (strcmp(argv[i], "--uenv") == 0 && (i + 1) < argc) {
+            c->uenv_path = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && (i + 1) < argc) {
+            c->device = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            c->json = true;
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            c->dry_run = true;
+        } else if (argv[i][0] == '-') {
+            return -1;
+        } else {
+            c->args[c->arg_count++] = argv[i];
+        }
+    }
+
+    switch (c->cmd) {
+        case CMD_GET:
+            return c->arg_count > 0 ? 0 : -1;
+        case CMD_ENABLE:
+        case CMD_DISABLE:
+            /* positional ids are ops like --enable/--disable, after the explicit ones */
+            if (c->arg_count == 0) return -1;
+            for (size_t i = 0; i < c->arg_count; i++) {
+                c->o.ops[c->o.op_count].enable = (c->cmd == CMD_ENABLE);
+                c->o.ops[c->o.op_count].id = c->args[i];
+                c->o.op_count++;
+            }
+            return 0;
+        case CMD_APPLY_PROFILE:
+            if (c->arg_count != 1 || c->o.profile) return -1;
+            c->o.profile = c->args[0];
+            return 0;
+        default:
+            return c->arg_count == 0 ? 0 : -1;
+    }
+}
+
+static int resolve_rev(cli_t *c) {
+    if (c->o.have_rev) return 0;
+    const device_provider_t override = {"override", device_provider_override_get, c->device};
+    const device_provider_t *const providers[] = {&override, &DEVICE_PROVIDER_ENV, &DEVICE_PROVIDER_CACHE,
+                                                  &DEVICE_PROVIDER_MTD};
+    device_info_t info;
+    char err[160];
+    if (device_info_probe(providers, sizeof(providers) / sizeof(providers[0]), &info, NULL, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: device revision unknown%s%s (use --rev or --device)\n", err[0] ? ": " : "", err);
+        return -1;
+    }
+    c->o.rev = info.rev;
+    c->o.have_rev = true;
+    return 0;
+}
+
+static int cmd_list(const cli_t *c, const cfg_state_t *st) {
+    const cfg_registry_t *reg = st->reg;
+    if (c->json) {
+        printf("{\"rev\":");
+        json_str(get_device_rev_str(c->o.rev));
+        printf(",\"items\":[");
+        for (size_t i = 0; i < reg->count; i++) {
+            const cfg_item_t *it = &reg->items[i];
+            printf("%s{\"id\":", i ? "," : "");
+            json_str(it->id);
+            printf(",\"category\":\"%s\",\"enabled\":%s,\"available\":%s}", CAT_NAMES[it->cat],
+                   cfg_state_is_enabled(st, i) ? "true" : "false",
+                   cfg_item_is_available(it, c->o.rev) ? "true" : "false");
+        }
+        printf("],\"unknown\":{");
+        for (int cat = 0; cat < 2; cat++) {
+            const cfg_intern_t *t = cfg_state_unknown(st, (cfg_category_t)cat);
+            printf("%s\"%s\":[", cat ? "," : "", CAT_NAMES[cat]);
+            for (uint32_t h = 0; h < t->count; h++) {
+                if (h) putchar(',');
+                json_str(cfg_intern_str(t, h));
+            }
+            putchar(']');
+        }
+        printf("}}\n");
+        return 0;
+    }
+
+    for (size_t i = 0; i < reg->count; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        const char *state = cfg_state_is_enabled(st, i) ? "enabled"
+                            : cfg_item_is_available(it, c->o.rev) ? "disabled" : "unavailable";
+        printf("%s\t%s\t%s\n", it->id, CAT_NAMES[it->cat], state);
+    }
+    for (int cat = 0; cat < 2; cat++) {
+        const cfg_intern_t *t = cfg_state_unknown(st, (cfg_category_t)cat);
+        for (uint32_t h = 0; h < t->count; h++) printf("%s\t%s\tunknown\n", cfg_intern_str(t, h), CAT_NAMES[cat]);
+    }
+    return 0;
+}
+
+/* 1 enabled, 0 disabled, -1 not an item and not in uEnv */
+static int item_enabled(const cfg_state_t *st, const char *id) {
+    const int idx = cfg_registry_find(st->reg, id);
+    if (idx >= 0) return cfg_state_is_enabled(st, (size_t)idx) ? 1 : 0;
+    if (cfg_intern_find(&st->unknown_interface, id) != CFG_INTERN_NONE ||
+        cfg_intern_find(&st->unknown_ext, id) != CFG_INTERN_NONE) {
+        return 1;
+    }
+    return -1;
+}
+
+static int cmd_get(const cli_t *c, const cfg_state_t *st) {
+    for (size_t i = 0; i < c->arg_count; i++) {
+        if (item_enabled(st, c->args[i]) < 0) {
+            fprintf(stderr, "srgn_config: unknown item '%s'\n", c->args[i]);
+            return 2;
+        }
+    }
+    bool all = true;
+    if (c->json) putchar('{');
+    for (size_t i = 0; i < c->arg_count; i++) {
+        const bool on = item_enabled(st, c->args[i]) == 1;
+        all = all && on;
+        if (c->json) {
+            if (i) putchar(',');
+            json_str(c->args[i]);
+            printf(":%s", on ? "true" : "false");
+        } else {
+            printf("%s\t%s\n", c->args[i], on ? "enabled" : "disabled");
+        }
+    }
+    if (c->json) printf("}\n");
+    return all ? 0 : 3;
+}
+
+static int cmd_validate(const cli_t *c, const cfg_state_t *st) {
+    char err[256];
+    const bool ok = cfg_state_validate(st, c->o.rev, err, sizeof(err)) == 0;
+    if (c->json) {
+        printf("{\"valid\":%s", ok ? "true" : "false");
+        if (!ok) {
+            printf(",\"error\":");
+            json_str(err);
+        }
+        printf("}\n");
+    } else if (ok) {
+        printf("ok\n");
+    } else {
+        fprintf(stderr, "srgn_config: invalid configuration: %s\n", err);
+    }
+    return ok ? 0 : 3;
+}
+
+/* Ops, then diff / write. before holds the lines as loaded. */
+static int cmd_edit(const cli_t *c, cfg_state_t *st, const cfg_lines_t *before, uenv_file_t *u) {
+    char err[256];
+    bool changed = false;
+    const int r = filter_apply_ops(st, &c->o, c->o.force ? filter_confirm_force : filter_confirm_strict, &changed,
+                                   err, sizeof(err));
+    if (r != 0) {
+        fprintf(stderr, "srgn_config: %s\n", err);
+        return r == -1 ? 2 : 3;
+    }
+    /* a broken config would only show up after a reboot; never write one */
+    if (c->cmd != CMD_DIFF && cfg_state_validate(st, c->o.rev, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: invalid configuration: %s\n", err);
+        return 3;
+    }
+
+    cfg_lines_t after = {0};
+    if (cfg_state_render(st, &after) != 0) {
+        fprintf(stderr, "srgn_config: out of memory\n");
+        return 2;
+    }
+    const bool iface_changed = strcmp(before->interface_line, after.interface_line) != 0;
+    const bool ext_changed = strcmp(before->ext_line, after.ext_line) != 0;
+    changed = iface_changed || ext_changed;
+
+    int ret = 0;
+    const bool write = c->cmd != CMD_DIFF && !c->dry_run && changed;
+    if (write && uenv_write_preserve(c->uenv_path, u, after.interface_line, after.ext_line, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: write failed: %s\n", err);
+        ret = 4;
+    }
+
+    if (c->json) {
+        printf("{\"changed\":%s,\"written\":%s,\"interface\":", changed ? "true" : "false",
+               (write && ret == 0) ? "true" : "false");
+        json_line(after.interface_line);
+        printf(",\"ext\":");
+        json_line(after.ext_line);
+        if (c->cmd == CMD_DIFF) {
+            printf(",\"old_interface\":");
+            json_line(before->interface_line);
+            printf(",\"old_ext\":");
+            json_line(before->ext_line);
+        }
+        printf("}\n");
+    } else if (c->cmd == CMD_DIFF || c->dry_run) {
+        if (iface_changed) printf("-%s+%s", before->interface_line, after.interface_line);
+        if (ext_changed) printf("-%s+%s", before->ext_line, after.ext_line);
+    }
+    cfg_lines_free(&after);
+    return ret;
+}
+
+int cli_run(int argc, char **argv) {
+    cli_t c = {0};
+    c.cmd = (cli_cmd_t)find_cmd(argv[1]);
+    c.o.ops = calloc((size_t)argc, sizeof(filter_op_t));
+    c.args = calloc((size_t)argc, sizeof(const char *));
+    if (!c.o.ops || !c.args) {
+        free(c.o.ops);
+        free(c.args);
+        return 2;
+    }
+
+    int ret = 0;
+    char err[256];
+    uenv_file_t u;
+    cfg_state_t st;
+    cfg_lines_t before = {0};
+    overlay_view_t view;
+    if (parse_args(&c, argc, argv) != 0) {
+        cli_usage();
+        ret = 1;
+        goto out;
+    }
+    if (resolve_rev(&c) != 0) {
+        ret = 2;
+        goto out;
+    }
+    if (uenv_load(c.uenv_path, &u, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: %s\n", err);
+        ret = 2;
+        goto out;
+    }
+    /* same registry as the TUI: pins from the overlays next to the file */
+    if (overlay_view_open(&view, c.uenv_path, c.o.rev) != 0 ||
+        cfg_state_init_from_uenv(&st, overlay_view_registry(&view), &u, c.o.rev) != 0 ||
+        cfg_state_render(&st, &before) != 0) {
+        fprintf(stderr, "srgn_config: failed to initialize config state\n");
+        overlay_view_free(&view);
+        uenv_free(&u);
+        ret = 2;
+        goto out;
+    }
+
+    switch (c.cmd) {
+        case CMD_LIST:
+            ret = cmd_list(&c, &st);
+            break;
+        case CMD_GET:
+            ret = cmd_get(&c, &st);
+            break;
+        case CMD_VALIDATE:
+            ret = cmd_validate(&c, &st);
+            break;
+        default:
+            ret = cmd_edit(&c, &st, &before, &u);
+            break;
+    }
+
+    cfg_lines_free(&before);
+    cfg_state_free(&st);
+    overlay_view_free(&view);
+    uenv_free(&u);
+out:
+    free(c.o.ops);
+    free(c.args);
+    return ret;
+}
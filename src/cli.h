@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+ * Headless subcommands on the same registry / state / uEnv engine as the TUI.
+ * They never touch the terminal settings or draw anything.
+ *
+ *   srgn_config list                           every item and unknown token with its state
+ *   srgn_config get ID...                      exit 0 if all are enabled, 3 if not
+ *   srgn_config enable ID... | disable ID...   edit and write uEnv.txt
+ *   srgn_config validate                       check the saved configuration
+ *   srgn_config diff [OPS]                     lines the ops would change, nothing written
+ *   srgn_config apply-profile NAME|CODE        replace the configuration with a profile
+ *
+ * Common options: --uenv PATH (default $SRGN_UENV_PATH, then /boot/uEnv.txt),
+ * --json, --dry-run (edits only print the result), and the shared --filter
+ * options (--rev, --profile, --target, --enable, --disable, --force) as OPS.
+ * Without --rev the revision comes from the device providers (--device,
+ * $SRGN_DEVICE, cache, flash).
+ */
+
+/* argv[1] names a subcommand */
+int cli_requested(int argc, char **argv);
+
+/* Exit code: 0 ok, 1 usage, 2 bad input, 3 rejected / invalid / not enabled, 4 write failed */
+int cli_run(int argc, char **argv);
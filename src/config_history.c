@@ -0,0 +1,81 @@
+#include "config_history.h"
+
+#include <string.h>
+
+void cfg_snapshot_take(const cfg_state_t *st, cfg_snapshot_t *out) {
+    out->enabled = st->enabled;
+    out->unknown_interface = st->unknown_interface.count;
+    out->unknown_ext = st->unknown_ext.count;
+    out->interface_gen = st->unknown_interface.generation;
+    out->ext_gen = st->unknown_ext.generation;
+}
+
+bool cfg_snapshot_valid(const cfg_state_t *st, const cfg_snapshot_t *s) {
+    return s->interface_gen == st->unknown_interface.generation && s->ext_gen == st->unknown_ext.generation &&
+           s->unknown_interface <= st->unknown_interface.total && s->unknown_ext <= st->unknown_ext.total;
+}
+
+int cfg_snapshot_restore(cfg_state_t *st, const cfg_snapshot_t *s) {
+    if (!cfg_snapshot_valid(st, s)) return -1;
+    if (cfg_intern_set_count(&st->unknown_interface, s->unknown_interface) != 0 ||
+        cfg_intern_set_count(&st->unknown_ext, s->unknown_ext) != 0) {
+        return -1; /* not reached: checked above */
+    }
+    st->enabled = s->enabled;
+    return 0;
+}
+
+bool cfg_snapshot_equal(const cfg_snapshot_t *a, const cfg_snapshot_t *b) {
+    return cfg_bits_equal(&a->enabled, &b->enabled) && a->unknown_interface == b->unknown_interface &&
+           a->unknown_ext == b->unknown_ext && a->interface_gen == b->interface_gen && a->ext_gen == b->ext_gen;
+}
+
+static cfg_snapshot_t *at(cfg_history_t *h, size_t i) {
+    return &h->ring[(h->head + i) % CFG_HISTORY_DEPTH];
+}
+
+void cfg_history_clear(cfg_history_t *h) {
+    h->head = 0;
+    h->undo = 0;
+    h->count = 0;
+}
+
+void cfg_history_push(cfg_history_t *h, const cfg_snapshot_t *before) {
+    if (h->undo == CFG_HISTORY_DEPTH) {
+        h->head = (h->head + 1) % CFG_HISTORY_DEPTH;
+        h->undo--;
+    }
+    *at(h, h->undo) = *before;
+    h->undo++;
+    h->count = h->undo;
+}
+
+void cfg_history_drop_stale(cfg_history_t *h, const cfg_state_t *st) {
+    for (size_t i = 0; i < h->count; i++) {
+        if (!cfg_snapshot_valid(st, at(h, i))) {
+            cfg_history_clear(h);
+            return;
+        }
+    }
+}
+
+/* The entry and the current state trade places, so the same slot serves the opposite direction */
+static int swap_with(cfg_snapshot_t *slot, cfg_state_t *st) {
+    cfg_snapshot_t cur;
+    cfg_snapshot_take(st, &cur);
+    if (cfg_snapshot_restore(st, slot) != 0) return -1;
+    *slot = cur;
+    return 0;
+}
+
+int cfg_history_undo(cfg_history_t *h, cfg_state_t *st) {
+    if (h->undo == 0 || swap_with(at(h, h->undo - 1), st) != 0) return -1;
+    h->undo--;
+    return 0;
+}
+
+int cfg_history_redo(cfg_history_t *h, cfg_state_t *st) {
+    if (h->undo == h->count || swap_with(at(h, h->undo), st) != 0) return -1;
+    h->undo++;
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_state.h"
+
+/*
+ * Undo/redo for cfg_state_t. A snapshot is the enabled bitset plus how many
+ * unknown tokens each category had (handles are dense in insertion order, so
+ * a prefix length names them), so taking or restoring one is a fixed-size copy.
+ * The prefix only means the same tokens while the intern table's generation
+ * is unchanged; a snapshot from an older generation is stale and can't be
+ * restored (cfg_history_drop_stale forgets such entries).
+ */
+
+#define CFG_HISTORY_DEPTH 64 /* oldest edits are dropped beyond this */
+
+typedef struct {
+    cfg_bits_t enabled;
+    uint32_t unknown_interface;
+    uint32_t unknown_ext;
+    uint32_t interface_gen;
+    uint32_t ext_gen;
+} cfg_snapshot_t;
+
+typedef struct {
+    cfg_snapshot_t ring[CFG_HISTORY_DEPTH];
+    size_t head;  /* ring index of the oldest entry */
+    size_t undo;  /* entries [0, undo) can be undone, newest last */
+    size_t count; /* entries [undo, count) can be redone, next first */
+} cfg_history_t;
+
+void cfg_snapshot_take(const cfg_state_t *st, cfg_snapshot_t *out);
+/* 0, or -1 with st unchanged if s is stale */
+int  cfg_snapshot_restore(cfg_state_t *st, const cfg_snapshot_t *s);
+bool cfg_snapshot_valid(const cfg_state_t *st, const cfg_snapshot_t *s);
+bool cfg_snapshot_equal(const cfg_snapshot_t *a, const cfg_snapshot_t *b);
+
+void cfg_history_clear(cfg_history_t *h);
+/* Record the state before an edit; the redo entries are dropped */
+void cfg_history_push(cfg_history_t *h, const cfg_snapshot_t *before);
+/* Clear the history if any entry is stale for st */
+void cfg_history_drop_stale(cfg_history_t *h, const cfg_state_t *st);
+/* Step st back / forward. Return 0, or -1 if there is nothing to undo / redo
+ * (or the entry is stale). */
+int  cfg_history_undo(cfg_history_t *h, cfg_state_t *st);
+int  cfg_history_redo(cfg_history_t *h, cfg_state_t *st);
@@ -0,0 +1,447 @@
+#define _GNU_SOURCE
+#include "config_profile.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef SRGN_PROFILE_DIR
+#define SRGN_PROFILE_DIR "/etc/srgn_config/profiles"
+#endif
+
+#define PROFILE_FORMAT     1
+#define PROFILE_RECORD_MAX 65536 /* 255 tokens of 255 bytes per category fit */
+
+static void set_err(char *err, size_t err_len, const char *fmt, ...) {
+    if (!err || !err_len) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, err_len, fmt, ap);
+    va_end(ap);
+}
+
+bool cfg_profile_name_ok(const char *name) {
+    if (!name || !name[0] || strlen(name) > CFG_PROFILE_NAME_MAX) return false;
+    for (const char *c = name; *c; c++) {
+        const bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+                        *c == '_' || *c == '-';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static int copy_tokens(cfg_intern_t *dst, const cfg_intern_t *src) {
+    for (uint32_t h = 0; h < src->count; h++) {
+        if (cfg_intern_len(src, h) > 255) return -1; /* the record stores u8 lengths */
+        if (cfg_intern_add(dst, cfg_intern_str(src, h), NULL) == CFG_INTERN_NONE) return -1;
+    }
+    return 0;
+}
+
+int cfg_profile_from_state(cfg_profile_t *p, const char *name, const cfg_state_t *st, device_rev_t rev) {
+    if (!p || !st || !st->reg || !cfg_profile_name_ok(name)) return -1;
+    memset(p, 0, sizeof(*p));
+    snprintf(p->name, sizeof(p->name), "%s", name);
+    p->registry = cfg_registry_fingerprint(st->reg);
+    p->rev = rev;
+    p->enabled = st->enabled;
+    if (st->unknown_interface.count > 255 || st->unknown_ext.count > 255 ||
+        copy_tokens(&p->unknown_interface, &st->unknown_interface) != 0 ||
+        copy_tokens(&p->unknown_ext, &st->unknown_ext) != 0) {
+        cfg_profile_free(p);
+        return -1;
+    }
+    return 0;
+}
+
+void cfg_profile_free(cfg_profile_t *p) {
+    if (!p) return;
+    cfg_intern_free(&p->unknown_interface);
+    cfg_intern_free(&p->unknown_ext);
+    memset(p, 0, sizeof(*p));
+}
+
+/* ---- binary record ---- */
+
+static uint16_t crc16_ccitt(const uint8_t *d, size_t n) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint16_t)(d[i] << 8);
+        for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+static void put_u8(uint8_t *buf, size_t len, size_t *off, uint8_t v) {
+    if (*off < len) buf[*off] = v;
+    (*off)++;
+}
+
+static void put_bytes(uint8_t *buf, size_t len, size_t *off, const void *s, size_t n) {
+    if (*off + n <= len) memcpy(buf + *off, s, n);
+    *off += n;
+}
+
+static void put_tokens(uint8_t *buf, size_t len, size_t *off, const cfg_intern_t *t) {
+    put_u8(buf, len, off, (uint8_t)t->count);
+    for (uint32_t h = 0; h < t->count; h++) {
+        const size_t n = cfg_intern_len(t, h);
+        put_u8(buf, len, off, (uint8_t)n);
+        put_bytes(buf, len, off, cfg_intern_str(t, h), n);
+    }
+}
+
+size_t cfg_profile_encode(const cfg_profile_t *p, uint8_t *buf, size_t len) {
+    if (!p) return 0;
+    if (!buf) len = 0;
+    size_t off = 0;
+
+    put_u8(buf, len, &off, PROFILE_FORMAT);
+    for (int i = 0; i < 4; i++) put_u8(buf, len, &off, (uint8_t)(p->registry >> (8 * i)));
+    put_u8(buf, len, &off, (uint8_t)p->rev);
+    const size_t name_len = strlen(p->name);
+    put_u8(buf, len, &off, (uint8_t)name_len);
+    put_bytes(buf, len, &off, p->name, name_len);
+
+    uint8_t bits[CFG_MAX_ITEMS / 8];
+    size_t nbits = 0;
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        bits[i] = (uint8_t)(p->enabled.w[i / 8] >> (8 * (i % 8)));
+        if (bits[i]) nbits = i + 1;
+    }
+    put_u8(buf, len, &off, (uint8_t)nbits);
+    put_bytes(buf, len, &off, bits, nbits);
+
+    put_tokens(buf, len, &off, &p->unknown_interface);
+    put_tokens(buf, len, &off, &p->unknown_ext);
+
+    const uint16_t crc = (off <= len) ? crc16_ccitt(buf, off) : 0;
+    put_u8(buf, len, &off, (uint8_t)crc);
+    put_u8(buf, len, &off, (uint8_t)(crc >> 8));
+    return off;
+}
+
+typedef struct {
+    const uint8_t *p;
+    size_t len;
+    size_t off;
+    bool bad;
+} reader_t;
+
+static uint8_t get_u8(reader_t *r) {
+    if (r->off >= r->len) {
+        r->bad = true;
+        return 0;
+    }
+    return r->p[r->off++];
+}
+
+static const uint8_t *get_bytes(reader_t *r, size_t n) {
+    if (n > r->len - r->off) {
+        r->bad = true;
+        return NULL;
+    }
+    const uint8_t *s = r->p + r->off;
+    r->off += n;
+    return s;
+}
+
+static int get_tokens(reader_t *r, cfg_intern_t *t) {
+    const uint8_t n = get_u8(r);
+    for (uint8_t k = 0; k < n && !r->bad; k++) {
+        const uint8_t tlen = get_u8(r);
+        const uint8_t *s = get_bytes(r, tlen);
+        if (!s || tlen == 0) return -1;
+        char tok[256];
+        memcpy(tok, s, tlen);
+        tok[tlen] = 0;
+        if (strlen(tok) != tlen || strpbrk(tok, " \t\r\n")) return -1; /* must be a uEnv token */
+        if (cfg_intern_add(t, tok, NULL) == CFG_INTERN_NONE) return -1;
+    }
+    return r->bad ? -1 : 0;
+}
+
+int cfg_profile_decode(cfg_profile_t *p, const uint8_t *buf, size_t len, char *err, size_t err_len) {
+    if (!p || !buf) return -1;
+    memset(p, 0, sizeof(*p));
+    if (len < 3 || crc16_ccitt(buf, len - 2) != (uint16_t)(buf[len - 2] | (buf[len - 1] << 8))) {
+        set_err(err, err_len, "profile is corrupted (checksum mismatch)");
+        return -1;
+    }
+    reader_t r = {.p = buf, .len = len - 2};
+    if (get_u8(&r) != PROFILE_FORMAT) {
+        set_err(err, err_len, "unsupported profile format");
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) p->registry |= (uint32_t)get_u8(&r) << (8 * i);
+    p->rev = (device_rev_t)get_u8(&r);
+
+    const uint8_t name_len = get_u8(&r);
+    const uint8_t *name = get_bytes(&r, name_len);
+    if (name && name_len <= CFG_PROFILE_NAME_MAX) {
+        memcpy(p->name, name, name_len);
+        p->name[name_len] = 0;
+    }
+
+    const uint8_t nbits = get_u8(&r);
+    const uint8_t *bits = get_bytes(&r, nbits);
+    if (bits && nbits <= CFG_MAX_ITEMS / 8) {
+        for (size_t i = 0; i < nbits; i++) p->enabled.w[i / 8] |= (uint64_t)bits[i] << (8 * (i % 8));
+    } else {
+        r.bad = true;
+    }
+
+    if (r.bad || !cfg_profile_name_ok(p->name) || device_rev_rank(p->rev) < 0 ||
+        get_tokens(&r, &p->unknown_interface) != 0 || get_tokens(&r, &p->unknown_ext) != 0 || r.off != r.len) {
+        cfg_profile_free(p);
+        set_err(err, err_len, "profile is malformed");
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- base32 ---- */
+
+static const char B32[] = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+static int b32_value(char c) {
+    if (c >= 'a' && c <= 'z') c = (char)(c - 'a' + 'A');
+    if (c == 'O') c = '0';
+    if (c == 'I' || c == 'L') c = '1';
+    const char *hit = (c && c != 'U') ? strchr(B32, c) : NULL;
+    return hit ? (int)(hit - B32) : -1;
+}
+
+size_t cfg_profile_export(const cfg_profile_t *p, char *buf, size_t len) {
+    uint8_t rec[PROFILE_RECORD_MAX];
+    const size_t n = cfg_profile_encode(p, rec, sizeof(rec));
+    if (n > sizeof(rec)) return 0;
+    if (!buf) len = 0;
+
+    size_t off = 0;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc = (acc << 8) | rec[i];
+        bits += 8;
+        while (bits >= 5) {
+            bits -= 5;
+            if (off + 1 < len) buf[off] = B32[(acc >> bits) & 31];
+            off++;
+        }
+    }
+    if (bits > 0) {
+        if (off + 1 < len) buf[off] = B32[(acc << (5 - bits)) & 31];
+        off++;
+    }
+    if (len) buf[off < len ? off : len - 1] = 0;
+    return off;
+}
+
+int cfg_profile_import(cfg_profile_t *p, const char *code, char *err, size_t err_len) {
+    if (!p || !code) return -1;
+    uint8_t rec[PROFILE_RECORD_MAX];
+    size_t n = 0;
+    uint32_t acc = 0;
+    int bits = 0;
+    for (const char *c = code; *c; c++) {
+        if (*c == '-' || *c == ' ') continue;
+        const int v = b32_value(*c);
+        if (v < 0) {
+            set_err(err, err_len, "invalid character '%c' in profile code", *c);
+            return -1;
+        }
+        acc = (acc << 5) | (uint32_t)v;
+        bits += 5;
+        if (bits >= 8) {
+            bits -= 8;
+            if (n == sizeof(rec)) {
+                set_err(err, err_len, "profile code is too long");
+                return -1;
+            }
+            rec[n++] = (uint8_t)(acc >> bits);
+        }
+    }
+    /* leftover bits are padding and must be zero */
+    if (bits >= 5 || (acc & ((1u << bits) - 1)) != 0) {
+        set_err(err, err_len, "profile code is truncated");
+        return -1;
+    }
+    return cfg_profile_decode(p, rec, n, err, err_len);
+}
+
+/* ---- applying ---- */
+
+int cfg_profile_apply(cfg_state_t *st,
+                      const cfg_profile_t *p,
+                      device_rev_t dev_rev,
+                      bool partial_ok,
+                      cfg_solution_t *sol,
+                      char *err,
+                      size_t err_len) {
+    if (!st || !st->reg || !p) return -1;
+    if (p->registry != cfg_registry_fingerprint(st->reg)) {
+        set_err(err, err_len, "profile %s was made with a different option table", p->name);
+        return -1;
+    }
+
+    cfg_solution_t local;
+    if (!sol) sol = &local;
+    if (cfg_solve(st->reg, dev_rev, &p->enabled, sol) < 0) {
+        set_err(err, err_len, "solver failed");
+        return -1;
+    }
+    if (cfg_bits_any(&sol->denied) && !partial_ok) {
+        char why[512];
+        cfg_solve_explain(st->reg, dev_rev, sol, why, sizeof(why));
+        for (char *q = why; *q; q++) {
+            if (*q == '\n') *q = q[1] ? ';' : 0;
+        }
+        if (p->rev != dev_rev) {
+            set_err(err, err_len, "profile %s (made on %s) does not fit %s: %s", p->name, get_device_rev_str(p->rev),
+                    get_device_rev_str(dev_rev), why);
+        } else {
+            set_err(err, err_len, "profile %s does not fit: %s", p->name, why);
+        }
+        return -4;
+    }
+
+    /* unknown tokens go in first: they are the only step that can fail */
+    const uint32_t n_if = st->unknown_interface.count;
+    const uint32_t n_ext = st->unknown_ext.count;
+    if (copy_tokens(&st->unknown_interface, &p->unknown_interface) != 0 ||
+        copy_tokens(&st->unknown_ext, &p->unknown_ext) != 0) {
+        (void)cfg_intern_set_count(&st->unknown_interface, n_if);
+        (void)cfg_intern_set_count(&st->unknown_ext, n_ext);
+        set_err(err, err_len, "out of memory");
+        return -1;
+    }
+    st->enabled = sol->enabled;
+    return 0;
+}
+
+/* ---- storage ---- */
+
+const char *cfg_profile_dir(void) {
+    const char *env = getenv("SRGN_PROFILE_DIR");
+    return (env && env[0]) ? env : SRGN_PROFILE_DIR;
+}
+
+int cfg_profile_save(const cfg_profile_t *p, char *err, size_t err_len) {
+    if (!p || !cfg_profile_name_ok(p->name)) {
+        set_err(err, err_len, "invalid profile name");
+        return -1;
+    }
+    uint8_t rec[PROFILE_RECORD_MAX];
+    const size_t n = cfg_profile_encode(p, rec, sizeof(rec));
+    if (n > sizeof(rec)) {
+        set_err(err, err_len, "profile is too large");
+        return -1;
+    }
+
+    const char *dir = cfg_profile_dir();
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        set_err(err, err_len, "cannot create %s: %s", dir, strerror(errno));
+        return -1;
+    }
+    char path[512];
+    char tmp[520];
+    snprintf(path, sizeof(path), "%s/%s" CFG_PROFILE_SUFFIX, dir, p->name);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp) {
+        set_err(err, err_len, "cannot write %s: %s", tmp, strerror(errno));
+        return -1;
+    }
+    const bool ok = fwrite(rec, 1, n, fp) == n;
+    if (fclose(fp) != 0 || !ok || rename(tmp, path) != 0) {
+        set_err(err, err_len, "cannot write %s: %s", path, strerror(errno));
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int cfg_profile_load(const char *name, cfg_profile_t *p, char *err, size_t err_len) {
+    if (!cfg_profile_name_ok(name)) {
+        set_err(err, err_len, "invalid profile name");
+        return -1;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s" CFG_PROFILE_SUFFIX, cfg_profile_dir(), name);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        set_err(err, err_len, "no profile named %s", name);
+        return -1;
+    }
+    uint8_t rec[PROFILE_RECORD_MAX];
+    const size_t n = fread(rec, 1, sizeof(rec), fp);
+    fclose(fp);
+    if (cfg_profile_decode(p, rec, n, err, err_len) != 0) return -1;
+    if (strcmp(p->name, name) != 0) {
+        set_err(err, err_len, "%s holds profile %s", path, p->name);
+        cfg_profile_free(p);
+        return -1;
+    }
+    return 0;
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+int cfg_profile_list(char ***names_out) {
+    if (!names_out) return -1;
+    *names_out = NULL;
+    DIR *d = opendir(cfg_profile_dir());
+    if (!d) return (errno == ENOENT) ? 0 : -1;
+
+    char **names = NULL;
+    int count = 0;
+    const size_t suffix_len = strlen(CFG_PROFILE_SUFFIX);
+    for (struct dirent *e; (e = readdir(d));) {
+        const size_t len = strlen(e->d_name);
+        if (len <= suffix_len || strcmp(e->d_name + len - suffix_len, CFG_PROFILE_SUFFIX) != 0) continue;
+        char *name = strndup(e->d_name, len - suffix_len);
+        char **nv = realloc(names, (size_t)(count + 1) * sizeof(char *));
+        if (!name || !nv) {
+            free(name);
+            cfg_profile_list_free(nv ? nv : names, count);
+            closedir(d);
+            return -1;
+        }
+        names = nv;
+        if (cfg_profile_name_ok(name)) {
+            names[count++] = name;
+        } else {
+            free(name);
+        }
+    }
+    closedir(d);
+    qsort(names, (size_t)count, sizeof(char *), cmp_str);
+    *names_out = names;
+    return count;
+}
+
+void cfg_profile_list_free(char **names, int count) {
+    for (int i = 0; i < count; i++) free(names[i]);
+    free(names);
+}
+
+int cfg_profile_resolve(const char *name_or_code, cfg_profile_t *p, char *err, size_t err_len) {
+    if (!name_or_code) return -1;
+    char path[512];
+    struct stat sb;
+    snprintf(path, sizeof(path), "%s/%s" CFG_PROFILE_SUFFIX, cfg_profile_dir(), name_or_code);
+    if (cfg_profile_name_ok(name_or_code) && stat(path, &sb) == 0) return cfg_profile_load(name_or_code, p, err, err_len);
+    if (cfg_profile_import(p, name_or_code, err, err_len) == 0) return 0;
+    if (cfg_profile_name_ok(name_or_code) && strlen(name_or_code) < 16) {
+        set_err(err, err_len, "no profile named %s", name_or_code); /* too short to be a code */
+    }
+    return -1;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cfg_intern.h"
+#include "config_solver.h"
+#include "config_state.h"
+
+/*
+ * Named configuration profiles.
+ *
+ * A profile is a whole configuration: the enabled bitset, the revision it was
+ * made for and the unknown tokens to carry along. It is stored as a compact
+ * binary record (one file per profile) and exported as a base32 string short
+ * enough to type. Record layout, multi-byte fields little-endian:
+ *
+ *   u8  format (1)
+ *   u32 registry fingerprint (cfg_registry_fingerprint)
+ *   u8  device_rev_t
+ *   u8  name length, name
+ *   u8  bitset length, bitset bytes (item 0 = bit 0 of byte 0; trailing zeros trimmed)
+ *   u8  unknown interface= tokens, each u8 length + bytes
+ *   u8  unknown ext= tokens, same
+ *   u16 CRC-16/CCITT of everything before it
+ */
+
+#define CFG_PROFILE_NAME_MAX 32
+#define CFG_PROFILE_SUFFIX   ".prof"
+
+typedef struct {
+    char name[CFG_PROFILE_NAME_MAX + 1];
+    uint32_t registry;  /* fingerprint of the registry the bitset refers to */
+    device_rev_t rev;   /* revision it was made on */
+    cfg_bits_t enabled;
+    cfg_intern_t unknown_interface;
+    cfg_intern_t unknown_ext;
+} cfg_profile_t;
+
+/* Names are 1..CFG_PROFILE_NAME_MAX of [A-Za-z0-9_-] (they become file names) */
+bool cfg_profile_name_ok(const char *name);
+
+int  cfg_profile_from_state(cfg_profile_t *p, const char *name, const cfg_state_t *st, device_rev_t rev);
+void cfg_profile_free(cfg_profile_t *p);
+
+/* Binary record, snprintf-style: returns the full length, writes only if it fits */
+size_t cfg_profile_encode(const cfg_profile_t *p, uint8_t *buf, size_t len);
+int    cfg_profile_decode(cfg_profile_t *p, const uint8_t *buf, size_t len, char *err, size_t err_len);
+
+/* Crockford base32 of the record ("0-9A-Z" without I L O U). Decoding ignores
+ * case, '-' and spaces, and reads O as 0 and I/L as 1. */
+size_t cfg_profile_export(const cfg_profile_t *p, char *buf, size_t len); /* snprintf-style */
+int    cfg_profile_import(cfg_profile_t *p, const char *code, char *err, size_t err_len);
+
+/* Replace the known items of st with the solver's best valid configuration
+ * for the profile on dev_rev and add the profile's unknown tokens.
+ * Without partial_ok, a profile item that cannot be enabled is an error (-4,
+ * reason in err) and st is unchanged. sol may be NULL.
+ * Returns 0, -1 on bad input (other registry, OOM), -4 if rejected. */
+int cfg_profile_apply(cfg_state_t *st,
+                      const cfg_profile_t *p,
+                      device_rev_t dev_rev,
+                      bool partial_ok,
+                      cfg_solution_t *sol,
+                      char *err,
+                      size_t err_len);
+
+/* Storage: $SRGN_PROFILE_DIR, else SRGN_PROFILE_DIR (build option) */
+const char *cfg_profile_dir(void);
+int  cfg_profile_save(const cfg_profile_t *p, char *err, size_t err_len);
+int  cfg_profile_load(const char *name, cfg_profile_t *p, char *err, size_t err_len);
+/* Sorted profile names (malloc'ed; free with cfg_profile_list_free). Returns the count, -1 on error. */
+int  cfg_profile_list(char ***names_out);
+void cfg_profile_list_free(char **names, int count);
+
+/* A stored profile if name_or_code names one, otherwise an exported code */
+int  cfg_profile_resolve(const char *name_or_code, cfg_profile_t *p, char *err, size_t err_len);
@@ -1,36 +1,41 @@
 #include "config_registry.h"
+#include "config_registry_index.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* dependency/conflict lists (static constants) */
 static const char *const REQ_CARDKB[] = {"i2c0"};
 static const char *const REQ_LSM6[]   = {"i2c0"};
 
-/*
- * Pin-based conflicts (from README pin usage):
- * - adc_pa123: PA1/PA2/PA3
- * - adc_pa1:   PA1
- * - uart1:     PA2/PA3
- * - i2s0_pa:   PA1/PA2/PA3/(PE3)
- * - i2s0_pe:   PA1/(PE5/PE6/PE3)
- */
-static const char *const CON_ADC_PA123[] = {"adc_pa1", "uart1", "i2s0_pa", "i2s0_pe"};
-static const char *const CON_ADC_PA1[]   = {"adc_pa123", "i2s0_pa", "i2s0_pe"};
-static const char *const CON_UART1[]     = {"adc_pa123", "i2s0_pa"};
-static const char *const CON_I2S_PA[]    = {"i2s0_pe", "adc_pa123", "adc_pa1", "uart1"};
-static const char *const CON_I2S_PE[]    = {"i2s0_pa", "adc_pa123", "adc_pa1"};
-static const char *const CON_UART2[]     = {"spi1"};
-static const char *const CON_SPI1[]     = {"uart2"};
-
+#define PA1  CFG_PIN_PA1
+#define PA2  CFG_PIN_PA2
+#define PA3  CFG_PIN_PA3
+#define PE3  CFG_PIN_PE3
+#define PE5  CFG_PIN_PE5
+#define PE6  CFG_PIN_PE6
+#define PE7  CFG_PIN_PE7
+#define PE8  CFG_PIN_PE8
+#define PE9  CFG_PIN_PE9
+#define PE10 CFG_PIN_PE10
+#define PD0  CFG_PIN_PD0
+#define PD12 CFG_PIN_PD12
 
+/* Pin usage from the README pin table; conflicts are derived from overlaps.
+ * Fallback when no compiled index is installed; data/registry.txt holds the
+ * same table in srgn_regc source form (srgn_regc --dump-builtin). */
 static const cfg_item_t ITEMS[] = {
     /* interface */
-    {.id = "adc_pa123", .cat = CFG_CAT_INTERFACE, .title = "adc_pa123", .help = "Use PA1/PA2/PA3 as ADC pins", .min_rev_rank = -1, .max_rev_rank = -1, .conflicts = CON_ADC_PA123, .conflicts_count = 4},
-    {.id = "adc_pa1",   .cat = CFG_CAT_INTERFACE, .title = "adc_pa1",   .help = "Use PA1 as ADC pin", .min_rev_rank = -1, .max_rev_rank = -1, .conflicts = CON_ADC_PA1, .conflicts_count = 3},
-    {.id = "i2c0",      .cat = CFG_CAT_INTERFACE, .title = "i2c0",      .help = "Enable I2C0\n(PD0/PD12 as I2C pins)", .min_rev_rank = -1, .max_rev_rank = -1},
-    {.id = "i2s0_pa",   .cat = CFG_CAT_INTERFACE, .title = "i2s0_pa",   .help = "Enable I2S0\n(PA1/PA2/PA3/PE3 routing)\n Only Available on Epass>=0.5", .min_rev_rank = 2, .max_rev_rank = -1, .conflicts = CON_I2S_PA, .conflicts_count = 4},
-    {.id = "i2s0_pe",   .cat = CFG_CAT_INTERFACE, .title = "i2s0_pe",   .help = "Enable I2S0\n(PA1/PE5/PE6/PE3 routing)\n Only Available on Epass>=0.5", .min_rev_rank = 2, .max_rev_rank = -1, .conflicts = CON_I2S_PE, .conflicts_count = 3},
-    {.id = "spi1",      .cat = CFG_CAT_INTERFACE, .title = "spi1",      .help = "Enable SPI1\n(PE7/PE8/PE9/PE10 as SPI pins)", .min_rev_rank = -1, .max_rev_rank = -1,.conflicts = CON_SPI1, .conflicts_count = 1},
-    {.id = "uart1",     .cat = CFG_CAT_INTERFACE, .title = "uart1",     .help = "Enable UART1\n(PA2/PA3 as UART1 pins)", .min_rev_rank = -1, .max_rev_rank = -1, .conflicts = CON_UART1, .conflicts_count = 2},
-    {.id = "uart2",     .cat = CFG_CAT_INTERFACE, .title = "uart2",     .help = "Enable UART2\n(PA7/PA8 as UART2 pins)", .min_rev_rank = -1, .max_rev_rank = -1,.conflicts = CON_UART2, .conflicts_count = 1},
+    {.id = "adc_pa123", .cat = CFG_CAT_INTERFACE, .title = "adc_pa123", .help = "Use PA1/PA2/PA3 as ADC pins", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PA1 | PA2 | PA3)},
+    {.id = "adc_pa1",   .cat = CFG_CAT_INTERFACE, .title = "adc_pa1",   .help = "Use PA1 as ADC pin", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PA1)},
+    {.id = "i2c0",      .cat = CFG_CAT_INTERFACE, .title = "i2c0",      .help = "Enable I2C0\n(PD0/PD12 as I2C pins)", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PD0 | PD12)},
+    {.id = "i2s0_pa",   .cat = CFG_CAT_INTERFACE, .title = "i2s0_pa",   .help = "Enable I2S0\n(PA1/PA2/PA3/PE3 routing)\n Only Available on Epass>=0.5", .min_rev_rank = 2, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PA1 | PA2 | PA3 | PE3)},
+    {.id = "i2s0_pe",   .cat = CFG_CAT_INTERFACE, .title = "i2s0_pe",   .help = "Enable I2S0\n(PA1/PE5/PE6/PE3 routing)\n Only Available on Epass>=0.5", .min_rev_rank = 2, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PA1 | PE5 | PE6 | PE3)},
+    {.id = "spi1",      .cat = CFG_CAT_INTERFACE, .title = "spi1",      .help = "Enable SPI1\n(PE7/PE8/PE9/PE10 as SPI pins)", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PE7 | PE8 | PE9 | PE10)},
+    {.id = "uart1",     .cat = CFG_CAT_INTERFACE, .title = "uart1",     .help = "Enable UART1\n(PA2/PA3 as UART1 pins)", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PA2 | PA3)},
+    {.id = "uart2",     .cat = CFG_CAT_INTERFACE, .title = "uart2",     .help = "Enable UART2\n(PE7/PE8 as UART2 pins)", .min_rev_rank = -1, .max_rev_rank = -1, .pins = CFG_PINS_ALL(PE7 | PE8)},
     {.id = "usbhost",   .cat = CFG_CAT_INTERFACE, .title = "usbhost",   .help = "Set USB mode to USB Host", .min_rev_rank = -1, .max_rev_rank = -1},
     {.id = "usbhs",     .cat = CFG_CAT_INTERFACE, .title = "usbhs",     .help = "Enable USB2.0 High-Speed mode", .min_rev_rank = -1, .max_rev_rank = -1},
 
@@ -39,12 +44,231 @@ static const cfg_item_t ITEMS[] = {
     {.id = "lsm6ds3_pre0.4",.cat = CFG_CAT_EXT, .title = "lsm6ds3_pre0.4",.help = "Enable onboard IMU support for <=0.4\n (requires i2c0)", .min_rev_rank = -1, .max_rev_rank = 1, .requires = REQ_LSM6, .requires_count = 1},
 };
 
+#define ITEM_COUNT (sizeof(ITEMS) / sizeof(ITEMS[0]))
+
+static cfg_registry_t s_builtin;
+static pthread_once_t s_builtin_once = PTHREAD_ONCE_INIT;
+static bool s_builtin_ok;
+
+static void builtin_init(void) {
+    s_builtin.items = ITEMS;
+    s_builtin.count = ITEM_COUNT;
+
+    /* lives for the whole process, like ITEMS */
+    const uint32_t cap = cfg_registry_hash_capacity(ITEM_COUNT);
+    uint16_t *slots = malloc(cap * sizeof(uint16_t));
+    if (!slots || cfg_registry_build_hash(&s_builtin, slots, cap) != 0) {
+        /* lookups fall back to a linear scan */
+        free(slots);
+        s_builtin.hash_size = 0;
+        s_builtin.hash_slots = NULL;
+    }
+
+    static cfg_bits_t masks[CFG_MASK_STORAGE(ITEM_COUNT)];
+    s_builtin_ok = (cfg_registry_build_masks(&s_builtin, masks) == 0);
+}
+
+const cfg_registry_t *cfg_registry_builtin(void) {
+    pthread_once(&s_builtin_once, builtin_init);
+    return s_builtin_ok ? &s_builtin : NULL;
+}
+
+static cfg_registry_t s_index;
+static const cfg_registry_t *s_reg;
+static pthread_once_t s_reg_once = PTHREAD_ONCE_INIT;
+
+static void registry_init(void) {
+    /* compiled index from srgn_regc if there is a usable one; $SRGN_REGISTRY="" forces the built-in table */
+    const char *path = getenv("SRGN_REGISTRY");
+    if (!path) path = SRGN_REGISTRY_PATH;
+    if (path[0] && cfg_registry_load_index(path, &s_index, NULL, 0) == 0) {
+        s_reg = &s_index;
+        return;
+    }
+    s_reg = cfg_registry_builtin();
+}
+
 const cfg_registry_t *cfg_registry_get(void) {
-    static const cfg_registry_t reg = {
-        .items = ITEMS,
-        .count = sizeof(ITEMS) / sizeof(ITEMS[0]),
-    };
-    return &reg;
+    pthread_once(&s_reg_once, registry_init);
+    return s_reg;
+}
+
+static const char *const PIN_NAMES[CFG_PIN_COUNT] = {
+    "PA1", "PA2", "PA3", "PE3", "PE5", "PE6", "PE7", "PE8", "PE9", "PE10", "PE11", "PD0", "PD12",
+};
+
+cfg_pins_t cfg_pin_from_name(const char *name) {
+    if (!name) return 0;
+    for (unsigned i = 0; i < CFG_PIN_COUNT; i++) {
+        if (strcmp(PIN_NAMES[i], name) == 0) return (cfg_pins_t)1 << i;
+    }
+    return 0;
+}
+
+const char *cfg_pin_name(cfg_pins_t pin) {
+    for (unsigned i = 0; i < CFG_PIN_COUNT; i++) {
+        if (pin == ((cfg_pins_t)1 << i)) return PIN_NAMES[i];
+    }
+    return NULL;
+}
+
+int cfg_registry_build_masks(cfg_registry_t *reg, cfg_bits_t *storage) {
+    if (!reg || !storage || reg->count > CFG_MAX_ITEMS) return -1;
+
+    const size_t n = reg->count;
+    cfg_bits_t *req = storage;
+    cfg_bits_t *closure = storage + n;
+    cfg_bits_t *dependents = storage + 2 * n;
+    cfg_bits_t *con = storage + 3 * n;
+    cfg_bits_t *enable_con = storage + (3 + CFG_REV_RANKS) * n;
+    memset(storage, 0, CFG_MASK_STORAGE(n) * sizeof(cfg_bits_t));
+    memset(reg->avail_mask, 0, sizeof(reg->avail_mask));
+
+    for (size_t i = 0; i < n; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        for (size_t r = 0; r < it->requires_count; r++) {
+            const int rix = cfg_registry_find(reg, it->requires[r]);
+            if (rix < 0) return -1;
+            cfg_bits_set(&req[i], (size_t)rix);
+        }
+        for (int rank = 0; rank < CFG_REV_RANKS; rank++) {
+            if (it->min_rev_rank >= 0 && rank < it->min_rev_rank) continue;
+            if (it->max_rev_rank >= 0 && rank > it->max_rev_rank) continue;
+            cfg_bits_set(&reg->avail_mask[rank], i);
+        }
+    }
+
+    for (int rank = 0; rank < CFG_REV_RANKS; rank++) {
+        cfg_bits_t *rc = con + (size_t)rank * n;
+        for (size_t i = 0; i < n; i++) {
+            const cfg_item_t *it = &reg->items[i];
+            /* pin overlaps, one AND per pair (items unusable on this revision claim nothing) */
+            if (cfg_bits_test(&reg->avail_mask[rank], i)) {
+                for (size_t j = i + 1; j < n; j++) {
+                    if (!cfg_bits_test(&reg->avail_mask[rank], j)) continue;
+                    if (it->pins[rank] & reg->items[j].pins[rank]) {
+                        cfg_bits_set(&rc[i], j);
+                        cfg_bits_set(&rc[j], i);
+                    }
+                }
+            }
+            for (size_t c = 0; c < it->conflicts_count; c++) {
+                const int cix = cfg_registry_find(reg, it->conflicts[c]);
+                if (cix < 0) return -1;
+                /* a conflict is mutual even if only one side lists it */
+                cfg_bits_set(&rc[i], (size_t)cix);
+                cfg_bits_set(&rc[cix], i);
+            }
+        }
+    }
+
+    /* transitive closure: iterate to a fixpoint (depth is tiny in practice, cycles terminate) */
+    memcpy(closure, req, n * sizeof(cfg_bits_t));
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (size_t i = 0; i < n; i++) {
+            cfg_bits_t next = closure[i];
+            for (size_t j = cfg_bits_next(&closure[i], 0); j < CFG_MAX_ITEMS; j = cfg_bits_next(&closure[i], j + 1)) {
+                cfg_bits_or_into(&next, &closure[j]);
+            }
+            if (!cfg_bits_equal(&next, &closure[i])) {
+                closure[i] = next;
+                grew = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        cfg_bits_clear(&closure[i], i);
+        for (size_t j = cfg_bits_next(&closure[i], 0); j < CFG_MAX_ITEMS; j = cfg_bits_next(&closure[i], j + 1)) {
+            cfg_bits_set(&dependents[j], i);
+        }
+        for (int rank = 0; rank < CFG_REV_RANKS; rank++) {
+            const size_t off = (size_t)rank * n;
+            enable_con[off + i] = con[off + i];
+            for (size_t j = cfg_bits_next(&closure[i], 0); j < CFG_MAX_ITEMS; j = cfg_bits_next(&closure[i], j + 1)) {
+                cfg_bits_or_into(&enable_con[off + i], &con[off + j]);
+            }
+        }
+    }
+
+    reg->requires_mask = req;
+    reg->requires_closure = closure;
+    reg->dependents = dependents;
+    reg->conflicts_mask = con;
+    reg->enable_conflicts = enable_con;
+    return 0;
+}
+
+/* FNV-1a with the seed folded into the offset basis, then a murmur3 finalizer */
+uint32_t cfg_hash_id(const char *id, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (const unsigned char *p = (const unsigned char *)id; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+uint32_t cfg_registry_fingerprint(const cfg_registry_t *reg) {
+    uint32_t h = (uint32_t)reg->count;
+    for (size_t i = 0; i < reg->count; i++) h = cfg_hash_id(reg->items[i].id, h);
+    return h;
+}
+
+/* Room for the initial table size and one doubling */
+uint32_t cfg_registry_hash_capacity(size_t count) {
+    uint32_t size = 4;
+    while (size < 2 * count) size <<= 1;
+    return size * 2;
+}
+
+int cfg_registry_build_hash(cfg_registry_t *reg, uint16_t *slots, uint32_t capacity) {
+    if (!reg || !slots || reg->count >= CFG_HASH_EMPTY) return -1;
+
+    /* load factor <= 1/2 keeps the seed search short; double once if it isn't */
+    uint32_t size = 4;
+    while (size < 2 * reg->count) size <<= 1;
+
+    for (; size <= capacity; size <<= 1) {
+        for (uint32_t seed = 1; seed < 4096; seed++) {
+            bool ok = true;
+            memset(slots, 0xFF, size * sizeof(uint16_t));
+            for (size_t i = 0; i < reg->count && ok; i++) {
+                const uint32_t slot = cfg_hash_id(reg->items[i].id, seed) & (size - 1);
+                if (slots[slot] != CFG_HASH_EMPTY) {
+                    ok = false;
+                } else {
+                    slots[slot] = (uint16_t)i;
+                }
+            }
+            if (ok) {
+                reg->hash_seed = seed;
+                reg->hash_size = size;
+                reg->hash_slots = slots;
+                return 0;
+            }
+        }
+    }
+    return -1;
+}
+
+int cfg_registry_find(const cfg_registry_t *reg, const char *id) {
+    if (!reg || !id) return -1;
+    if (!reg->hash_slots) {
+        for (size_t i = 0; i < reg->count; i++) {
+            if (strcmp(reg->items[i].id, id) == 0) return (int)i;
+        }
+        return -1;
+    }
+    const uint16_t idx = reg->hash_slots[cfg_hash_id(id, reg->hash_seed) & (reg->hash_size - 1)];
+    if (idx == CFG_HASH_EMPTY || strcmp(reg->items[idx].id, id) != 0) return -1;
+    return idx;
 }
 
 int device_rev_rank(device_rev_t rev) {
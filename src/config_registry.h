@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
+#include "cfg_bits.h"
 #include "device.h"
 
 typedef enum {
@@ -9,6 +11,33 @@ typedef enum {
     CFG_CAT_EXT       = 1,
 } cfg_category_t;
 
+#define CFG_REV_RANKS  4
+
+/*
+ * SoC pins an overlay claims. Two items conflict on a revision when their
+ * pin masks intersect there, so conflicts never have to be listed by hand.
+ */
+typedef uint32_t cfg_pins_t;
+
+#define CFG_PIN_PA1  (1u << 0)
+#define CFG_PIN_PA2  (1u << 1)
+#define CFG_PIN_PA3  (1u << 2)
+#define CFG_PIN_PE3  (1u << 3)  /* exposed on >=0.5 */
+#define CFG_PIN_PE5  (1u << 4)
+#define CFG_PIN_PE6  (1u << 5)
+#define CFG_PIN_PE7  (1u << 6)
+#define CFG_PIN_PE8  (1u << 7)
+#define CFG_PIN_PE9  (1u << 8)
+#define CFG_PIN_PE10 (1u << 9)
+#define CFG_PIN_PE11 (1u << 10) /* exposed on <=0.4 in place of PE3 */
+#define CFG_PIN_PD0  (1u << 11)
+#define CFG_PIN_PD12 (1u << 12)
+#define CFG_PIN_COUNT 13
+
+/* pins[] initializers: same routing on every revision / pre-0.5 vs 0.5+ routing */
+#define CFG_PINS_ALL(m)              {(m), (m), (m), (m)}
+#define CFG_PINS_BY_REV(pre05, post05) {(pre05), (pre05), (post05), (post05)}
+
 typedef struct {
     const char *id;     /* token name (written into uEnv token list) */
     cfg_category_t cat; /* interface / ext */
@@ -23,17 +52,78 @@ typedef struct {
     const char *const *requires;
     size_t requires_count;
 
+    /* pins claimed when enabled, indexed by revision rank */
+    cfg_pins_t pins[CFG_REV_RANKS];
+
+    /* conflicts that are not about pins (pin conflicts are derived from pins[]) */
     const char *const *conflicts;
     size_t conflicts_count;
 } cfg_item_t;
 
+#define CFG_HASH_EMPTY 0xFFFFu
+
 typedef struct {
     const cfg_item_t *items;
     size_t count;
+
+    /* Perfect hash over item ids: every id maps to its own slot, so a lookup
+     * is one hash plus one strcmp. slot = cfg_hash_id(id, hash_seed) & (hash_size - 1) */
+    uint32_t hash_seed;
+    uint32_t hash_size;           /* power of two */
+    const uint16_t *hash_slots;   /* item index or CFG_HASH_EMPTY */
+
+    /* requires/pins/conflicts compiled into per-item masks (cfg_registry_build_masks).
+     * Conflict masks depend on the revision: use the accessors below. */
+    const cfg_bits_t *requires_mask;    /* direct requirements */
+    const cfg_bits_t *requires_closure; /* transitive requirements, without the item itself */
+    const cfg_bits_t *dependents;       /* reverse closure: items that (transitively) require it */
+    const cfg_bits_t *conflicts_mask;   /* [rank * count + i], symmetric */
+    const cfg_bits_t *enable_conflicts; /* [rank * count + i], item plus its whole requirement closure */
+    cfg_bits_t avail_mask[CFG_REV_RANKS]; /* items usable on each revision rank */
 } cfg_registry_t;
 
+/* Registry in use: the compiled index at $SRGN_REGISTRY / SRGN_REGISTRY_PATH
+ * if it loads, otherwise the built-in table. Resolved once (thread-safe).
+ * Returns NULL only if the built-in table is inconsistent. */
 const cfg_registry_t *cfg_registry_get(void);
 
+/* The built-in table (ITEMS[] in config_registry.c); hash and masks built on first use */
+const cfg_registry_t *cfg_registry_builtin(void);
+
+/* Index of the item with this id, or -1 */
+int cfg_registry_find(const cfg_registry_t *reg, const char *id);
+
+uint32_t cfg_hash_id(const char *id, uint32_t seed);
+
+/* Hash of the item ids in index order: equal fingerprints mean a bitset
+ * means the same items in both registries */
+uint32_t cfg_registry_fingerprint(const cfg_registry_t *reg);
+
+/* Search a seed that makes reg->items collision-free and fill the hash_* fields.
+ * slots must hold at least cfg_registry_hash_capacity(reg->count) entries. */
+int cfg_registry_build_hash(cfg_registry_t *reg, uint16_t *slots, uint32_t capacity);
+uint32_t cfg_registry_hash_capacity(size_t count);
+
+/* Number of cfg_bits_t cfg_registry_build_masks needs for count items */
+#define CFG_MASK_STORAGE(count) ((3 + 2 * CFG_REV_RANKS) * (count))
+
+/* Resolve requires/conflicts ids and pin overlaps into masks; storage holds
+ * CFG_MASK_STORAGE(reg->count) entries. Needs the hash index.
+ * Fails on unknown ids or more than CFG_MAX_ITEMS items. */
+int cfg_registry_build_masks(cfg_registry_t *reg, cfg_bits_t *storage);
+
+static inline const cfg_bits_t *cfg_registry_conflicts(const cfg_registry_t *reg, int rank, size_t i) {
+    return &reg->conflicts_mask[(size_t)rank * reg->count + i];
+}
+
+static inline const cfg_bits_t *cfg_registry_enable_conflicts(const cfg_registry_t *reg, int rank, size_t i) {
+    return &reg->enable_conflicts[(size_t)rank * reg->count + i];
+}
+
+/* Pin name ("PE3") <-> CFG_PIN_* bit; 0 / NULL if unknown */
+cfg_pins_t  cfg_pin_from_name(const char *name);
+const char *cfg_pin_name(cfg_pins_t pin);
+
 /* Device revision rank (for min/max constraints) */
 int device_rev_rank(device_rev_t rev);
 
@@ -0,0 +1,304 @@
+#include "config_registry_index.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INDEX_ALIGN 8u
+
+static size_t align_up(size_t v) {
+    return (v + INDEX_ALIGN - 1) & ~(size_t)(INDEX_ALIGN - 1);
+}
+
+/* ---- writer ---- */
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} strtab_t;
+
+/* Append s (with its NUL) and return its offset, or CFG_INDEX_NONE on allocation failure */
+static uint32_t strtab_add(strtab_t *t, const char *s) {
+    const size_t n = strlen(s) + 1;
+    if (t->len + n > t->cap) {
+        size_t cap = t->cap ? t->cap : 1024;
+        while (t->len + n > cap) cap *= 2;
+        char *nb = realloc(t->buf, cap);
+        if (!nb) return CFG_INDEX_NONE;
+        t->buf = nb;
+        t->cap = cap;
+    }
+    memcpy(t->buf + t->len, s, n);
+    const uint32_t off = (uint32_t)t->len;
+    t->len += n;
+    return off;
+}
+
+static int write_at(FILE *fp, size_t off, const void *p, size_t n) {
+    if (fseek(fp, (long)off, SEEK_SET) != 0) return -1;
+    return (n == 0 || fwrite(p, 1, n, fp) == n) ? 0 : -1;
+}
+
+int cfg_registry_write_index(const cfg_registry_t *reg, FILE *fp, char *err, size_t err_len) {
+    if (!reg || !fp || !reg->hash_slots || !reg->requires_mask) {
+        if (err && err_len) snprintf(err, err_len, "registry has no hash index or masks");
+        return -1;
+    }
+    if (err && err_len) err[0] = 0;
+    const size_t n = reg->count;
+
+    cfg_index_item_t *items = calloc(n ? n : 1, sizeof(cfg_index_item_t));
+    size_t ref_total = 0;
+    for (size_t i = 0; i < n; i++) ref_total += reg->items[i].requires_count + reg->items[i].conflicts_count;
+    uint32_t *refs = calloc(ref_total ? ref_total : 1, sizeof(uint32_t));
+    strtab_t strings = {0};
+    int ret = -1;
+    if (!items || !refs) goto out;
+
+    /* ids first so requires/conflicts can point at them */
+    for (size_t i = 0; i < n; i++) {
+        items[i].id = strtab_add(&strings, reg->items[i].id);
+        if (items[i].id == CFG_INDEX_NONE) goto out;
+    }
+    size_t r = 0;
+    for (size_t i = 0; i < n; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        cfg_index_item_t *rec = &items[i];
+        rec->title = strtab_add(&strings, it->title ? it->title : it->id);
+        rec->help = it->help ? strtab_add(&strings, it->help) : CFG_INDEX_NONE;
+        if (rec->title == CFG_INDEX_NONE || (it->help && rec->help == CFG_INDEX_NONE)) goto out;
+        rec->cat = (uint32_t)it->cat;
+        rec->min_rev_rank = it->min_rev_rank;
+        rec->max_rev_rank = it->max_rev_rank;
+        memcpy(rec->pins, it->pins, sizeof(rec->pins));
+
+        rec->requires_first = (uint32_t)r;
+        rec->requires_count = (uint32_t)it->requires_count;
+        for (size_t k = 0; k < it->requires_count; k++) {
+            const int j = cfg_registry_find(reg, it->requires[k]);
+            if (j < 0) {
+                if (err && err_len) snprintf(err, err_len, "%s requires unknown item %s", it->id, it->requires[k]);
+                goto out;
+            }
+            refs[r++] = items[j].id;
+        }
+        rec->conflicts_first = (uint32_t)r;
+        rec->conflicts_count = (uint32_t)it->conflicts_count;
+        for (size_t k = 0; k < it->conflicts_count; k++) {
+            const int j = cfg_registry_find(reg, it->conflicts[k]);
+            if (j < 0) {
+                if (err && err_len) snprintf(err, err_len, "%s conflicts with unknown item %s", it->id, it->conflicts[k]);
+                goto out;
+            }
+            refs[r++] = items[j].id;
+        }
+    }
+
+    cfg_index_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CFG_INDEX_MAGIC, sizeof(h.magic));
+    h.version = CFG_INDEX_VERSION;
+    h.bom = CFG_INDEX_BOM;
+    h.item_count = (uint32_t)n;
+    h.bits_words = CFG_BITS_WORDS;
+    h.rev_ranks = CFG_REV_RANKS;
+    h.hash_seed = reg->hash_seed;
+    h.hash_size = reg->hash_size;
+    h.refs_count = (uint32_t)ref_total;
+
+    size_t off = align_up(sizeof(h));
+    h.items_off = (uint32_t)off;
+    off = align_up(off + n * sizeof(cfg_index_item_t));
+    h.refs_off = (uint32_t)off;
+    off = align_up(off + ref_total * sizeof(uint32_t));
+    h.hash_off = (uint32_t)off;
+    off = align_up(off + reg->hash_size * sizeof(uint16_t));
+    h.masks_off = (uint32_t)off;
+    off = align_up(off + CFG_MASK_STORAGE(n) * sizeof(cfg_bits_t));
+    h.avail_off = (uint32_t)off;
+    off = align_up(off + CFG_REV_RANKS * sizeof(cfg_bits_t));
+    h.strings_off = (uint32_t)off;
+    h.strings_size = (uint32_t)strings.len;
+    off += strings.len;
+    if (off > UINT32_MAX) goto out;
+    h.file_size = (uint32_t)off;
+
+    /* masks in cfg_registry_build_masks layout: requires, closure, dependents, conflicts[rank], enable[rank] */
+    size_t m = h.masks_off;
+    const size_t row = n * sizeof(cfg_bits_t);
+    if (write_at(fp, 0, &h, sizeof(h)) != 0 ||
+        write_at(fp, h.items_off, items, n * sizeof(cfg_index_item_t)) != 0 ||
+        write_at(fp, h.refs_off, refs, ref_total * sizeof(uint32_t)) != 0 ||
+        write_at(fp, h.hash_off, reg->hash_slots, reg->hash_size * sizeof(uint16_t)) != 0 ||
+        write_at(fp, m, reg->requires_mask, row) != 0 ||
+        write_at(fp, m += row, reg->requires_closure, row) != 0 ||
+        write_at(fp, m += row, reg->dependents, row) != 0 ||
+        write_at(fp, m += row, reg->conflicts_mask, CFG_REV_RANKS * row) != 0 ||
+        write_at(fp, m + CFG_REV_RANKS * row, reg->enable_conflicts, CFG_REV_RANKS * row) != 0 ||
+        write_at(fp, h.avail_off, reg->avail_mask, sizeof(reg->avail_mask)) != 0 ||
+        write_at(fp, h.strings_off, strings.buf, strings.len) != 0) {
+        if (err && err_len) snprintf(err, err_len, "write failed: %s", strerror(errno));
+        goto out;
+    }
+    ret = 0;
+
+out:
+    if (ret != 0 && err && err_len && !err[0]) snprintf(err, err_len, "out of memory");
+    free(items);
+    free(refs);
+    free(strings.buf);
+    return ret;
+}
+
+/* ---- loader ---- */
+
+static bool section_ok(const cfg_index_header_t *h, uint64_t off, uint64_t size, uint64_t align) {
+    return off % align == 0 && off + size <= h->file_size;
+}
+
+static bool string_ok(const cfg_index_header_t *h, uint32_t off) {
+    return off < h->strings_size;
+}
+
+static int load_fail(char *err, size_t err_len, const char *path, const char *why) {
+    if (err && err_len) snprintf(err, err_len, "%s: %s", path, why);
+    return -1;
+}
+
+int cfg_registry_load_index(const char *path, cfg_registry_t *reg, char *err, size_t err_len) {
+    if (!path || !reg) return -1;
+    if (err && err_len) err[0] = 0;
+
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return load_fail(err, err_len, path, strerror(errno));
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size < (off_t)sizeof(cfg_index_header_t) || sb.st_size > (off_t)UINT32_MAX) {
+        close(fd);
+        return load_fail(err, err_len, path, "not a registry index");
+    }
+    const size_t size = (size_t)sb.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return load_fail(err, err_len, path, strerror(errno));
+
+    const unsigned char *base = map;
+    const cfg_index_header_t *h = map;
+    const char *why = NULL;
+    cfg_item_t *items = NULL;
+
+    if (memcmp(h->magic, CFG_INDEX_MAGIC, sizeof(h->magic)) != 0) {
+        why = "not a registry index";
+    } else if (h->version != CFG_INDEX_VERSION || h->bom != CFG_INDEX_BOM) {
+        why = "index was built for another version or byte order";
+    } else if (h->bits_words != CFG_BITS_WORDS || h->rev_ranks != CFG_REV_RANKS) {
+        why = "index was built with different limits";
+    } else if (h->file_size != size) {
+        why = "truncated index";
+    } else if (h->item_count > CFG_MAX_ITEMS || h->hash_size < h->item_count || h->hash_size == 0 ||
+               (h->hash_size & (h->hash_size - 1)) != 0) {
+        why = "bad item count or hash size";
+    } else if (!section_ok(h, h->items_off, (uint64_t)h->item_count * sizeof(cfg_index_item_t), 4) ||
+               !section_ok(h, h->refs_off, (uint64_t)h->refs_count * sizeof(uint32_t), 4) ||
+               !section_ok(h, h->hash_off, (uint64_t)h->hash_size * sizeof(uint16_t), 2) ||
+               !section_ok(h, h->masks_off, (uint64_t)CFG_MASK_STORAGE(h->item_count) * sizeof(cfg_bits_t), INDEX_ALIGN) ||
+               !section_ok(h, h->avail_off, CFG_REV_RANKS * sizeof(cfg_bits_t), INDEX_ALIGN) ||
+               !section_ok(h, h->strings_off, h->strings_size, 1) || h->strings_size == 0 ||
+               base[h->strings_off + h->strings_size - 1] != 0) {
+        why = "section out of bounds";
+    }
+    if (why) goto fail;
+
+    const size_t n = h->item_count;
+    const cfg_index_item_t *rec = (const cfg_index_item_t *)(base + h->items_off);
+    const uint32_t *refs = (const uint32_t *)(base + h->refs_off);
+    const char *strings = (const char *)(base + h->strings_off);
+
+    /* item views: cfg_item_t array plus the requires/conflicts pointer lists */
+    items = calloc(1, n * sizeof(cfg_item_t) + h->refs_count * sizeof(char *) + 1);
+    if (!items) {
+        why = "out of memory";
+        goto fail;
+    }
+    const char **ref_ptrs = (const char **)(items + n);
+    for (size_t i = 0; i < h->refs_count; i++) {
+        if (!string_ok(h, refs[i])) {
+            why = "bad string offset";
+            goto fail;
+        }
+        ref_ptrs[i] = strings + refs[i];
+    }
+    for (size_t i = 0; i < n; i++) {
+        const cfg_index_item_t *r = &rec[i];
+        if (!string_ok(h, r->id) || !string_ok(h, r->title) || (r->help != CFG_INDEX_NONE && !string_ok(h, r->help)) ||
+            r->cat > CFG_CAT_EXT || r->min_rev_rank < -1 || r->min_rev_rank >= CFG_REV_RANKS ||
+            r->max_rev_rank < -1 || r->max_rev_rank >= CFG_REV_RANKS ||
+            (uint64_t)r->requires_first + r->requires_count > h->refs_count ||
+            (uint64_t)r->conflicts_first + r->conflicts_count > h->refs_count) {
+            why = "bad item record";
+            goto fail;
+        }
+        cfg_item_t *it = &items[i];
+        it->id = strings + r->id;
+        it->title = strings + r->title;
+        it->help = (r->help != CFG_INDEX_NONE) ? strings + r->help : NULL;
+        it->cat = (cfg_category_t)r->cat;
+        it->min_rev_rank = r->min_rev_rank;
+        it->max_rev_rank = r->max_rev_rank;
+        it->requires = ref_ptrs + r->requires_first;
+        it->requires_count = r->requires_count;
+        it->conflicts = ref_ptrs + r->conflicts_first;
+        it->conflicts_count = r->conflicts_count;
+        memcpy(it->pins, r->pins, sizeof(it->pins));
+    }
+
+    cfg_registry_t out;
+    memset(&out, 0, sizeof(out));
+    out.items = items;
+    out.count = n;
+    out.hash_seed = h->hash_seed;
+    out.hash_size = h->hash_size;
+    out.hash_slots = (const uint16_t *)(base + h->hash_off);
+
+    /* the hash has to map every id to itself, or lookups would silently miss */
+    for (size_t s = 0; s < h->hash_size; s++) {
+        if (out.hash_slots[s] != CFG_HASH_EMPTY && out.hash_slots[s] >= n) why = "bad hash slot";
+    }
+    for (size_t i = 0; i < n && !why; i++) {
+        if (cfg_registry_find(&out, items[i].id) != (int)i) why = "hash index does not match the items";
+    }
+    if (why) goto fail;
+
+    /* no mask may name an item past the end, or bit iteration would index out of items[] */
+    cfg_bits_t all = {{0}};
+    for (size_t i = 0; i < n; i++) cfg_bits_set(&all, i);
+    const cfg_bits_t *masks = (const cfg_bits_t *)(base + h->masks_off);
+    for (size_t i = 0; i < CFG_MASK_STORAGE(n) && !why; i++) {
+        if (!cfg_bits_subset(&masks[i], &all)) why = "mask names an unknown item";
+    }
+    const cfg_bits_t *avail = (const cfg_bits_t *)(base + h->avail_off);
+    for (size_t r = 0; r < CFG_REV_RANKS && !why; r++) {
+        if (!cfg_bits_subset(&avail[r], &all)) why = "mask names an unknown item";
+    }
+    if (why) goto fail;
+
+    out.requires_mask = masks;
+    out.requires_closure = masks + n;
+    out.dependents = masks + 2 * n;
+    out.conflicts_mask = masks + 3 * n;
+    out.enable_conflicts = masks + (3 + CFG_REV_RANKS) * n;
+    memcpy(out.avail_mask, avail, sizeof(out.avail_mask));
+
+    *reg = out;
+    return 0;
+
+fail:
+    free(items);
+    munmap(map, size);
+    return load_fail(err, err_len, path, why);
+}
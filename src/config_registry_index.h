@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "config_registry.h"
+
+/*
+ * Compiled registry index: one file holding the item records, a string
+ * table, the perfect-hash slots and the masks cfg_registry_build_masks would
+ * produce, laid out so it can be mmapped and used in place. Built by
+ * srgn_regc from a readable source file (data/registry.txt).
+ *
+ * Native byte order; a file written on a different architecture is rejected
+ * (and the built-in table is used instead).
+ */
+
+#define CFG_INDEX_MAGIC   "SRGNREG\0"
+#define CFG_INDEX_VERSION 1
+#define CFG_INDEX_BOM     0x01020304u
+#define CFG_INDEX_NONE    0xFFFFFFFFu /* string offset of an absent help text */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t bom;          /* CFG_INDEX_BOM as written by the compiler */
+    uint32_t file_size;
+    uint32_t item_count;
+    uint32_t bits_words;   /* CFG_BITS_WORDS */
+    uint32_t rev_ranks;    /* CFG_REV_RANKS */
+    uint32_t hash_seed;
+    uint32_t hash_size;
+
+    /* byte offsets from the start of the file; tables are 8-byte aligned */
+    uint32_t items_off;    /* cfg_index_item_t[item_count] */
+    uint32_t refs_off;     /* uint32_t string offsets of requires/conflicts ids */
+    uint32_t refs_count;
+    uint32_t hash_off;     /* uint16_t[hash_size] */
+    uint32_t masks_off;    /* cfg_bits_t[CFG_MASK_STORAGE(item_count)], build_masks layout */
+    uint32_t avail_off;    /* cfg_bits_t[CFG_REV_RANKS] */
+    uint32_t strings_off;  /* NUL-terminated strings */
+    uint32_t strings_size;
+} cfg_index_header_t;
+
+typedef struct {
+    uint32_t id;           /* string offsets */
+    uint32_t title;
+    uint32_t help;         /* or CFG_INDEX_NONE */
+    uint32_t cat;
+    int32_t min_rev_rank;
+    int32_t max_rev_rank;
+    uint32_t requires_first; /* index into refs */
+    uint32_t requires_count;
+    uint32_t conflicts_first;
+    uint32_t conflicts_count;
+    uint32_t pins[CFG_REV_RANKS];
+} cfg_index_item_t;
+
+/* Default location of the compiled index (overridden by $SRGN_REGISTRY) */
+#ifndef SRGN_REGISTRY_PATH
+#define SRGN_REGISTRY_PATH "/etc/srgn_config/registry"
+#endif
+
+/* Serialize a registry with hash and masks built. Returns 0 or -1 (err set). */
+int cfg_registry_write_index(const cfg_registry_t *reg, FILE *fp, char *err, size_t err_len);
+
+/* Map an index file and point reg at it. The mapping stays for the life of
+ * the process; only the item views (pointer fixups, no string parsing) are
+ * allocated. Returns 0, or -1 with err set if the file is missing or invalid. */
+int cfg_registry_load_index(const char *path, cfg_registry_t *reg, char *err, size_t err_len);
@@ -0,0 +1,192 @@
+#include "config_solver.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SOLVE_MEMO_BITS 14
+#define SOLVE_MEMO_SIZE (1u << SOLVE_MEMO_BITS)
+
+typedef struct {
+    uint32_t depth; /* 0 = empty slot, otherwise depth + 1 */
+    cfg_bits_t state;
+} solve_memo_t;
+
+typedef struct {
+    const cfg_registry_t *reg;
+    int rank;
+    const cfg_bits_t *wish;
+
+    size_t order[CFG_MAX_ITEMS]; /* feasible wishes, registry order */
+    cfg_bits_t need[CFG_MAX_ITEMS]; /* wish plus its requirement closure, by order index */
+    size_t order_count;
+
+    cfg_bits_t best;
+    size_t best_score;
+
+    solve_memo_t *memo; /* NULL if the allocation failed: search still works, just slower */
+} solve_ctx_t;
+
+/* Items that can never be enabled together with the given set */
+static cfg_bits_t forbidden_by(const solve_ctx_t *c, const cfg_bits_t *set) {
+    cfg_bits_t f = {{0}};
+    for (size_t i = cfg_bits_next(set, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(set, i + 1)) {
+        cfg_bits_or_into(&f, cfg_registry_conflicts(c->reg, c->rank, i));
+    }
+    return f;
+}
+
+static size_t score_of(const solve_ctx_t *c, const cfg_bits_t *state) {
+    const cfg_bits_t got = cfg_bits_and(state, c->wish);
+    return cfg_bits_count(&got);
+}
+
+/* true if (depth, state) was seen before; records it otherwise */
+static bool memo_seen(solve_ctx_t *c, size_t depth, const cfg_bits_t *state) {
+    if (!c->memo) return false;
+    uint64_t h = 0x9e3779b97f4a7c15ull * (depth + 1);
+    for (size_t k = 0; k < CFG_BITS_WORDS; k++) {
+        h ^= state->w[k];
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+    }
+    for (uint32_t probe = 0; probe < 8; probe++) {
+        solve_memo_t *m = &c->memo[(h + probe) & (SOLVE_MEMO_SIZE - 1)];
+        if (m->depth == 0) {
+            m->depth = (uint32_t)depth + 1;
+            m->state = *state;
+            return false;
+        }
+        if (m->depth == depth + 1 && cfg_bits_equal(&m->state, state)) return true;
+    }
+    return false; /* neighbourhood full: just don't memoize this one */
+}
+
+static void search(solve_ctx_t *c, size_t k, const cfg_bits_t *state, const cfg_bits_t *forbidden, size_t score) {
+    if (score > c->best_score) {
+        c->best_score = score;
+        c->best = *state;
+    }
+    if (k == c->order_count) return;
+    /* bound: even granting every remaining wish can't beat the best */
+    if (score + (c->order_count - k) <= c->best_score) return;
+    if (memo_seen(c, k, state)) return;
+
+    const size_t w = c->order[k];
+    if (cfg_bits_test(state, w)) {
+        /* already pulled in as somebody's requirement */
+        search(c, k + 1, state, forbidden, score);
+        return;
+    }
+
+    /* take it, if neither it nor its closure hits anything excluded by the current state */
+    if (!cfg_bits_intersects(&c->need[k], forbidden)) {
+        cfg_bits_t next = *state;
+        cfg_bits_or_into(&next, &c->need[k]);
+        cfg_bits_t nforbidden = *forbidden;
+        const cfg_bits_t added = forbidden_by(c, &c->need[k]);
+        cfg_bits_or_into(&nforbidden, &added);
+        search(c, k + 1, &next, &nforbidden, score_of(c, &next));
+    }
+
+    /* or leave it out */
+    search(c, k + 1, state, forbidden, score);
+}
+
+/* Can w be enabled at all on this revision (ignoring other wishes)? */
+static bool wish_feasible(const solve_ctx_t *c, size_t w, cfg_bits_t *need_out) {
+    cfg_bits_t need = c->reg->requires_closure[w];
+    cfg_bits_set(&need, w);
+    *need_out = need;
+    if (!cfg_bits_subset(&need, &c->reg->avail_mask[c->rank])) return false;
+    const cfg_bits_t f = forbidden_by(c, &need);
+    return !cfg_bits_intersects(&f, &need);
+}
+
+int cfg_solve(const cfg_registry_t *reg,
+              device_rev_t dev_rev,
+              const cfg_bits_t *wish,
+              cfg_solution_t *out) {
+    if (!reg || !wish || !out) return -1;
+    memset(out, 0, sizeof(*out));
+    const int rank = device_rev_rank(dev_rev);
+    if (rank < 0) return -1;
+
+    solve_ctx_t *c = calloc(1, sizeof(*c));
+    if (!c) return -1;
+    c->reg = reg;
+    c->rank = rank;
+    c->wish = wish;
+
+    for (size_t w = cfg_bits_next(wish, 0); w < reg->count; w = cfg_bits_next(wish, w + 1)) {
+        cfg_bits_t need;
+        if (wish_feasible(c, w, &need)) {
+            c->need[c->order_count] = need;
+            c->order[c->order_count++] = w;
+        }
+    }
+
+    c->memo = calloc(SOLVE_MEMO_SIZE, sizeof(solve_memo_t));
+    const cfg_bits_t empty = {{0}};
+    search(c, 0, &empty, &empty, 0);
+    free(c->memo);
+
+    out->enabled = c->best;
+    out->granted = cfg_bits_and(&c->best, wish);
+    out->denied = cfg_bits_andnot(wish, &c->best);
+    free(c);
+    return (int)cfg_bits_count(&out->granted);
+}
+
+size_t cfg_solve_explain(const cfg_registry_t *reg,
+                         device_rev_t dev_rev,
+                         const cfg_solution_t *sol,
+                         char *buf,
+                         size_t len) {
+    size_t off = 0;
+    if (buf && len) buf[0] = 0;
+    if (!reg || !sol) return 0;
+    const int rank = device_rev_rank(dev_rev);
+
+#define EXPLAIN(...)                                                             \
+    do {                                                                         \
+        const int n_ = snprintf(buf ? buf + (off < len ? off : len) : NULL,      \
+                                (buf && off < len) ? len - off : 0, __VA_ARGS__); \
+        if (n_ > 0) off += (size_t)n_;                                           \
+    } while (0)
+
+    for (size_t w = cfg_bits_next(&sol->denied, 0); w < reg->count; w = cfg_bits_next(&sol->denied, w + 1)) {
+        const char *id = reg->items[w].id;
+        cfg_bits_t need = reg->requires_closure[w];
+        cfg_bits_set(&need, w);
+
+        if (rank < 0 || !cfg_bits_test(&reg->avail_mask[rank], w)) {
+            EXPLAIN("%s: unavailable on %s\n", id, get_device_rev_str(dev_rev));
+            continue;
+        }
+        const cfg_bits_t unavail = rank < 0 ? need : cfg_bits_andnot(&need, &reg->avail_mask[rank]);
+        if (cfg_bits_any(&unavail)) {
+            EXPLAIN("%s: requires %s, unavailable on %s\n", id, reg->items[cfg_bits_next(&unavail, 0)].id,
+                    get_device_rev_str(dev_rev));
+            continue;
+        }
+
+        /* the kept items that block it: conflicts of w or of anything w pulls in */
+        bool said = false;
+        for (size_t j = cfg_bits_next(&need, 0); j < CFG_MAX_ITEMS; j = cfg_bits_next(&need, j + 1)) {
+            const cfg_bits_t hit = cfg_bits_and(cfg_registry_conflicts(reg, rank, j), &sol->enabled);
+            for (size_t h = cfg_bits_next(&hit, 0); h < CFG_MAX_ITEMS; h = cfg_bits_next(&hit, h + 1)) {
+                if (j == w) {
+                    EXPLAIN("%s: conflicts with %s\n", id, reg->items[h].id);
+                } else {
+                    EXPLAIN("%s: requires %s, which conflicts with %s\n", id, reg->items[j].id, reg->items[h].id);
+                }
+                said = true;
+            }
+        }
+        if (!said) EXPLAIN("%s: its requirements conflict with each other\n", id);
+    }
+#undef EXPLAIN
+    return off;
+}
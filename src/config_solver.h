@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "config_registry.h"
+
+/*
+ * Whole-configuration solver.
+ *
+ * Given a set of wished-for items and a device revision, finds the valid
+ * configuration (available on the revision, requirement closures enabled,
+ * no conflicting pair) that contains the most wishes. Ties go to wishes that
+ * come earlier in the registry. Backtracking over bitset state with
+ * memoization of visited (depth, state) pairs; no prompts.
+ */
+
+typedef struct {
+    cfg_bits_t enabled; /* resulting valid configuration */
+    cfg_bits_t granted; /* wishes contained in enabled */
+    cfg_bits_t denied;  /* wishes that could not be satisfied */
+} cfg_solution_t;
+
+/* Returns the number of granted wishes, or -1 on invalid arguments. */
+int cfg_solve(const cfg_registry_t *reg,
+              device_rev_t dev_rev,
+              const cfg_bits_t *wish,
+              cfg_solution_t *out);
+
+/* Explain every denied wish, one line each ("i2s0_pa: conflicts with uart1").
+ * Returns the length that would have been written (snprintf-style). */
+size_t cfg_solve_explain(const cfg_registry_t *reg,
+                         device_rev_t dev_rev,
+                         const cfg_solution_t *sol,
+                         char *buf,
+                         size_t len);
@@ -4,41 +4,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-static void free_strv(char **v, size_t n) {
-    if (!v) return;
-    for (size_t i = 0; i < n; i++) free(v[i]);
-    free(v);
-}
-
-static int strv_push(char ***v, size_t *n, const char *s) {
-    char **nv = realloc(*v, (*n + 1) * sizeof(char *));
-    if (!nv) return -1;
-    nv[*n] = strdup(s ? s : "");
-    if (!nv[*n]) {
-        *v = nv;
-        return -1;
-    }
-    *v = nv;
-    *n = *n + 1;
-    return 0;
-}
-
-static int strv_contains(char *const *v, size_t n, const char *s) {
-    if (!s) return 0;
-    for (size_t i = 0; i < n; i++) {
-        if (v[i] && strcmp(v[i], s) == 0) return 1;
-    }
-    return 0;
-}
-
-static int find_item_index_by_id(const cfg_registry_t *reg, const char *id) {
-    if (!reg || !id) return -1;
-    for (size_t i = 0; i < reg->count; i++) {
-        if (reg->items[i].id && strcmp(reg->items[i].id, id) == 0) return (int)i;
-    }
-    return -1;
-}
-
 bool cfg_item_is_available(const cfg_item_t *it, device_rev_t dev_rev) {
     if (!it) return false;
     const int r = device_rev_rank(dev_rev);
@@ -48,6 +13,28 @@ bool cfg_item_is_available(const cfg_item_t *it, device_rev_t dev_rev) {
     return true;
 }
 
+/* Sizes the table for every token of the line so the loop below never reallocates */
+static int add_unknowns(cfg_intern_t *t,
+                        const cfg_registry_t *reg,
+                        char *const *tokens,
+                        size_t n,
+                        cfg_category_t cat,
+                        cfg_bits_t *enabled) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < n; i++) bytes += strlen(tokens[i]);
+    if (n && cfg_intern_reserve(t, n, bytes) != 0) return -1;
+
+    for (size_t i = 0; i < n; i++) {
+        const int idx = cfg_registry_find(reg, tokens[i]);
+        if (idx >= 0 && reg->items[idx].cat == cat) {
+            cfg_bits_set(enabled, (size_t)idx);
+        } else if (cfg_intern_add(t, tokens[i], NULL) == CFG_INTERN_NONE) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 int cfg_state_init_from_uenv(cfg_state_t *st,
                              const cfg_registry_t *reg,
                              const uenv_file_t *u,
@@ -56,84 +43,44 @@ int cfg_state_init_from_uenv(cfg_state_t *st,
     if (!st || !reg || !u) return -1;
     memset(st, 0, sizeof(*st));
     st->reg = reg;
-    st->enabled = calloc(reg->count, sizeof(bool));
-    if (!st->enabled) return -1;
-
-    /* interface tokens */
-    for (size_t i = 0; i < u->interface_token_count; i++) {
-        const char *tok = u->interface_tokens[i];
-        const int idx = find_item_index_by_id(reg, tok);
-        if (idx >= 0 && reg->items[idx].cat == CFG_CAT_INTERFACE) {
-            st->enabled[idx] = true;
-        } else {
-            if (!strv_contains(st->unknown_interface, st->unknown_interface_count, tok)) {
-                if (strv_push(&st->unknown_interface, &st->unknown_interface_count, tok) != 0) {
-                    cfg_state_free(st);
-                    return -1;
-                }
-            }
-        }
-    }
 
-    /* ext tokens */
-    for (size_t i = 0; i < u->ext_token_count; i++) {
-        const char *tok = u->ext_tokens[i];
-        const int idx = find_item_index_by_id(reg, tok);
-        if (idx >= 0 && reg->items[idx].cat == CFG_CAT_EXT) {
-            st->enabled[idx] = true;
-        } else {
-            if (!strv_contains(st->unknown_ext, st->unknown_ext_count, tok)) {
-                if (strv_push(&st->unknown_ext, &st->unknown_ext_count, tok) != 0) {
-                    cfg_state_free(st);
-                    return -1;
-                }
-            }
-        }
+    if (add_unknowns(&st->unknown_interface, reg, u->interface_tokens, u->interface_token_count, CFG_CAT_INTERFACE,
+                     &st->enabled) != 0 ||
+        add_unknowns(&st->unknown_ext, reg, u->ext_tokens, u->ext_token_count, CFG_CAT_EXT, &st->enabled) != 0) {
+        cfg_state_free(st);
+        return -1;
     }
-
     return 0;
 }
 
 void cfg_state_free(cfg_state_t *st) {
     if (!st) return;
-    free(st->enabled);
-    free_strv(st->unknown_interface, st->unknown_interface_count);
-    free_strv(st->unknown_ext, st->unknown_ext_count);
+    cfg_intern_free(&st->unknown_interface);
+    cfg_intern_free(&st->unknown_ext);
+    free(st->unknown_interface_overlay);
+    free(st->unknown_ext_overlay);
     memset(st, 0, sizeof(*st));
 }
 
-static int enable_item_recursive(cfg_state_t *st, size_t idx, device_rev_t dev_rev, int depth) {
-    if (!st || !st->reg) return -1;
-    if (idx >= st->reg->count) return -1;
-    if (depth > 16) return -1; /* prevent cycles from exploding */
-
-    const cfg_item_t *it = &st->reg->items[idx];
-    if (!cfg_item_is_available(it, dev_rev)) return -2;
-
-    /* enable dependencies first */
-    for (size_t r = 0; r < it->requires_count; r++) {
-        const char *rid = it->requires[r];
-        const int rix = find_item_index_by_id(st->reg, rid);
-        if (rix < 0) return -1;
-        if (enable_item_recursive(st, (size_t)rix, dev_rev, depth + 1) < 0) return -1;
-    }
-
-    st->enabled[idx] = true;
-    return 0;
-}
-
 int cfg_state_toggle(cfg_state_t *st,
                      size_t item_index,
                      device_rev_t dev_rev,
                      int (*confirm)(const char *title, const char *prompt)) {
-    if (!st || !st->reg || !st->enabled) return -1;
+    if (!st || !st->reg) return -1;
     if (item_index >= st->reg->count) return -1;
 
-    const cfg_item_t *it = &st->reg->items[item_index];
+    const cfg_registry_t *reg = st->reg;
+    const cfg_item_t *it = &reg->items[item_index];
 
-    if (!st->enabled[item_index]) {
-        /* enable */
-        if (!cfg_item_is_available(it, dev_rev)) return -2;
+    if (!cfg_bits_test(&st->enabled, item_index)) {
+        /* enable: the item and its whole requirement closure must be usable here */
+        const int rank = device_rev_rank(dev_rev);
+        if (rank < 0 || !cfg_item_is_available(it, dev_rev)) return -2;
+        cfg_bits_t closure = reg->requires_closure[item_index];
+        cfg_bits_set(&closure, item_index);
+        if (!cfg_bits_subset(&closure, &reg->avail_mask[rank])) return -2;
+        /* a closure that conflicts with itself can never be enabled */
+        if (cfg_bits_intersects(&closure, cfg_registry_enable_conflicts(reg, rank, item_index))) return -2;
 
         if (confirm) {
             char help[256];
@@ -144,74 +91,145 @@ int cfg_state_toggle(cfg_state_t *st,
             }
         }
 
-        /* conflicts: if a conflict is enabled, ask to disable it */
-        for (size_t c = 0; c < it->conflicts_count; c++) {
-            const char *cid = it->conflicts[c];
-            const int cix = find_item_index_by_id(st->reg, cid);
-            if (cix < 0) continue;
-            if (st->enabled[cix]) {
-                if (!confirm) return -3;
-                char prompt[256];
+        /* conflicts of the item or anything it pulls in: ask to disable each enabled one,
+         * together with the enabled items that need it */
+        const cfg_bits_t hits = cfg_bits_and(&st->enabled, cfg_registry_enable_conflicts(reg, rank, item_index));
+        cfg_bits_t next = st->enabled;
+        for (size_t c = cfg_bits_next(&hits, 0); c < CFG_MAX_ITEMS; c = cfg_bits_next(&hits, c + 1)) {
+            if (!confirm) return -3;
+            const char *cid = reg->items[c].id;
+            const cfg_bits_t users = cfg_bits_and(&st->enabled, &reg->dependents[c]);
+            const size_t user_count = cfg_bits_count(&users);
+            char prompt[256];
+            if (user_count) {
+                snprintf(prompt, sizeof(prompt), "Enabling %s \nconflicts with\n %s.\nDisable %s\n and %zu item(s) using it?",
+                         it->id, cid, cid, user_count);
+            } else {
                 snprintf(prompt, sizeof(prompt), "Enabling %s \nconflicts with\n %s.\nDisable %s?", it->id, cid, cid);
-                const int ans = confirm("Conflict", prompt);
-                if (ans != 0) {
-                    return -4; /* user rejected */
-                }
-                st->enabled[cix] = false;
             }
+            const int ans = confirm("Conflict", prompt);
+            if (ans != 0) {
+                return -4; /* user rejected; nothing has been changed yet */
+            }
+            cfg_bits_clear(&next, c);
+            next = cfg_bits_andnot(&next, &users);
         }
 
-        /* enable (including recursive dependencies) */
-        return enable_item_recursive(st, item_index, dev_rev, 0);
+        /* enable (including transitive dependencies) */
+        cfg_bits_or_into(&next, &closure);
+        st->enabled = next;
+        return 0;
     }
 
-    /* disable: only disable itself (do not auto-disable reverse dependencies) */
-    st->enabled[item_index] = false;
+    /* disable: enabled items that (transitively) require this one go with it */
+    const cfg_bits_t users = cfg_bits_and(&st->enabled, &reg->dependents[item_index]);
+    if (cfg_bits_any(&users)) {
+        if (!confirm) return -3;
+        char names[160];
+        size_t off = 0;
+        names[0] = 0;
+        for (size_t d = cfg_bits_next(&users, 0); d < CFG_MAX_ITEMS && off < sizeof(names); d = cfg_bits_next(&users, d + 1)) {
+            off += (size_t)snprintf(names + off, sizeof(names) - off, "%s %s", off ? "," : "", reg->items[d].id);
+        }
+        char prompt[256];
+        snprintf(prompt, sizeof(prompt), "Disabling %s \nalso disables\n%s.\nContinue?", it->id, names);
+        if (confirm("Dependents", prompt) != 0) {
+            return -4; /* user rejected */
+        }
+        st->enabled = cfg_bits_andnot(&st->enabled, &users);
+    }
+    cfg_bits_clear(&st->enabled, item_index);
     return 0;
 }
 
-int cfg_state_build_tokens(const cfg_state_t *st,
-                           cfg_category_t cat,
-                           char ***tokens_out,
-                           size_t *count_out) {
-    if (!tokens_out || !count_out || !st || !st->reg || !st->enabled) return -1;
-    *tokens_out = NULL;
-    *count_out = 0;
+int cfg_state_validate(const cfg_state_t *st, device_rev_t dev_rev, char *err, size_t err_len) {
+    if (!st || !st->reg) return -1;
 
-    /* known tokens: stable output order = registry order */
-    for (size_t i = 0; i < st->reg->count; i++) {
-        const cfg_item_t *it = &st->reg->items[i];
-        if (it->cat != cat) continue;
-        if (!st->enabled[i]) continue;
-        if (strv_push(tokens_out, count_out, it->id) != 0) {
-            free_strv(*tokens_out, *count_out);
-            *tokens_out = NULL;
-            *count_out = 0;
+    const cfg_registry_t *reg = st->reg;
+    const int rank = device_rev_rank(dev_rev);
+    const cfg_bits_t *en = &st->enabled;
+
+    for (size_t i = cfg_bits_next(en, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(en, i + 1)) {
+        const cfg_item_t *it = &reg->items[i];
+
+        if (rank < 0 || !cfg_bits_test(&reg->avail_mask[rank], i)) {
+            if (err && err_len) snprintf(err, err_len, "%s is unavailable on %s", it->id, get_device_rev_str(dev_rev));
+            return -1;
+        }
+        if (!cfg_bits_subset(&reg->requires_mask[i], en)) {
+            const cfg_bits_t missing = cfg_bits_andnot(&reg->requires_mask[i], en);
+            if (err && err_len) snprintf(err, err_len, "%s requires %s", it->id, reg->items[cfg_bits_next(&missing, 0)].id);
+            return -1;
+        }
+        const cfg_bits_t *con = cfg_registry_conflicts(reg, rank, i);
+        if (cfg_bits_intersects(con, en)) {
+            const cfg_bits_t hit = cfg_bits_and(con, en);
+            if (err && err_len) snprintf(err, err_len, "%s conflicts with %s", it->id, reg->items[cfg_bits_next(&hit, 0)].id);
             return -1;
         }
     }
+    return 0;
+}
+
+static const char *const LINE_KEY[] = {[CFG_CAT_INTERFACE] = "interface=", [CFG_CAT_EXT] = "ext="};
 
+/* Copies n bytes if they fit; the offset advances either way so the total comes out exact */
+static inline void put(char *buf, size_t len, size_t *off, const char *s, size_t n) {
+    if (*off + n < len) memcpy(buf + *off, s, n);
+    *off += n;
+}
+
+size_t cfg_state_format_line(const cfg_state_t *st, cfg_category_t cat, char *buf, size_t len) {
+    if (!st || !st->reg || (cat != CFG_CAT_INTERFACE && cat != CFG_CAT_EXT)) return 0;
+    if (!buf) len = 0;
+
+    const char *key = LINE_KEY[cat];
+    size_t off = 0;
+    put(buf, len, &off, key, strlen(key));
+    const size_t first = off;
+
+    /* known tokens: stable output order = registry order */
+    const cfg_registry_t *reg = st->reg;
+    for (size_t i = cfg_bits_next(&st->enabled, 0); i < reg->count; i = cfg_bits_next(&st->enabled, i + 1)) {
+        if (reg->items[i].cat != cat) continue;
+        if (off != first) put(buf, len, &off, " ", 1);
+        put(buf, len, &off, reg->items[i].id, strlen(reg->items[i].id));
+    }
     /* unknown tokens: keep original order from uEnv */
-    if (cat == CFG_CAT_INTERFACE) {
-        for (size_t i = 0; i < st->unknown_interface_count; i++) {
-            if (strv_push(tokens_out, count_out, st->unknown_interface[i]) != 0) {
-                free_strv(*tokens_out, *count_out);
-                *tokens_out = NULL;
-                *count_out = 0;
-                return -1;
-            }
-        }
-    } else {
-        for (size_t i = 0; i < st->unknown_ext_count; i++) {
-            if (strv_push(tokens_out, count_out, st->unknown_ext[i]) != 0) {
-                free_strv(*tokens_out, *count_out);
-                *tokens_out = NULL;
-                *count_out = 0;
-                return -1;
-            }
-        }
+    const cfg_intern_t *unknown = cfg_state_unknown(st, cat);
+    for (uint32_t h = 0; h < unknown->count; h++) {
+        if (off != first) put(buf, len, &off, " ", 1);
+        put(buf, len, &off, cfg_intern_str(unknown, h), cfg_intern_len(unknown, h));
     }
+    put(buf, len, &off, "\n", 1);
 
-    return 0;
+    if (off < len) buf[off] = 0;
+    return off;
+}
+
+int cfg_state_render(const cfg_state_t *st, cfg_lines_t *out) {
+    if (!st || !out) return -1;
+    /* one pass when the buffer from the last render is big enough; sizing pass otherwise */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        const size_t if_len = cfg_state_format_line(st, CFG_CAT_INTERFACE, out->buf, out->cap);
+        const size_t rest = (if_len + 1 < out->cap) ? out->cap - if_len - 1 : 0;
+        const size_t ex_len = cfg_state_format_line(st, CFG_CAT_EXT, rest ? out->buf + if_len + 1 : NULL, rest);
+        const size_t need = if_len + 1 + ex_len + 1;
+        if (need <= out->cap) {
+            out->interface_line = out->buf;
+            out->ext_line = out->buf + if_len + 1;
+            return 0;
+        }
+        char *nb = realloc(out->buf, need);
+        if (!nb) return -1;
+        out->buf = nb;
+        out->cap = need;
+    }
+    return -1;
 }
 
+void cfg_lines_free(cfg_lines_t *l) {
+    if (!l) return;
+    free(l->buf);
+    memset(l, 0, sizeof(*l));
+}
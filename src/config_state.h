@@ -3,18 +3,30 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "cfg_intern.h"
 #include "config_registry.h"
 #include "uenv.h"
 
+/* What is known about the .dtbo file behind a token (see overlay_scan.h) */
+typedef enum {
+    CFG_OVERLAY_UNCHECKED = 0, /* overlay directory not scanned */
+    CFG_OVERLAY_PRESENT,
+    CFG_OVERLAY_MISSING,
+} cfg_overlay_t;
+
 typedef struct {
     const cfg_registry_t *reg;
-    bool *enabled; /* len = reg->count */
+    cfg_bits_t enabled; /* bit i = reg->items[i] */
+
+    /* tokens present in uEnv but not recognized by the registry (must be preserved on save);
+     * handles 0..count-1 are the distinct tokens in uEnv order */
+    cfg_intern_t unknown_interface;
+    cfg_intern_t unknown_ext;
 
-    /* tokens present in uEnv but not recognized by the registry (must be preserved on save) */
-    char **unknown_interface;
-    size_t unknown_interface_count;
-    char **unknown_ext;
-    size_t unknown_ext_count;
+    /* overlay status of the unknown tokens, indexed by handle;
+     * NULL until overlay_label_state() runs */
+    cfg_overlay_t *unknown_interface_overlay;
+    cfg_overlay_t *unknown_ext_overlay;
 } cfg_state_t;
 
 int  cfg_state_init_from_uenv(cfg_state_t *st,
@@ -23,16 +35,50 @@ int  cfg_state_init_from_uenv(cfg_state_t *st,
                               device_rev_t dev_rev);
 void cfg_state_free(cfg_state_t *st);
 
+static inline bool cfg_state_is_enabled(const cfg_state_t *st, size_t item_index) {
+    return cfg_bits_test(&st->enabled, item_index);
+}
+
+static inline const cfg_intern_t *cfg_state_unknown(const cfg_state_t *st, cfg_category_t cat) {
+    return (cat == CFG_CAT_INTERFACE) ? &st->unknown_interface : &st->unknown_ext;
+}
+
 bool cfg_item_is_available(const cfg_item_t *it, device_rev_t dev_rev);
 
-/* confirm callback: return 0 for Yes, non-zero for No */
+/* confirm callback: return 0 for Yes, non-zero for No.
+ * Titles: "Confirm" (item description), "Conflict" (disable a conflicting item),
+ * "Dependents" (disabling also disables the enabled items that require it).
+ * Returns 0, -2 unavailable, -3 needs a prompt but confirm is NULL, -4 rejected. */
 int cfg_state_toggle(cfg_state_t *st,
                      size_t item_index,
                      device_rev_t dev_rev,
                      int (*confirm)(const char *title, const char *prompt));
 
-int cfg_state_build_tokens(const cfg_state_t *st,
-                           cfg_category_t cat,
-                           char ***tokens_out,
-                           size_t *count_out);
+/* Whole-state check: every enabled item is available on dev_rev, its
+ * requirements are enabled and none of its conflicts are.
+ * Returns 0 if valid; otherwise -1 with the first problem described in err. */
+int cfg_state_validate(const cfg_state_t *st, device_rev_t dev_rev, char *err, size_t err_len);
+
+/* Enabled items that (transitively) require item_index */
+static inline cfg_bits_t cfg_state_dependents(const cfg_state_t *st, size_t item_index) {
+    return cfg_bits_and(&st->enabled, &st->reg->dependents[item_index]);
+}
+
+/* Serialized "interface=tok tok\n" or "ext=...\n" line for one category:
+ * enabled items in registry order, then the unknown tokens in uEnv order.
+ * snprintf-style: returns the exact length (without NUL) and only writes
+ * when it fits (len > returned length). */
+size_t cfg_state_format_line(const cfg_state_t *st, cfg_category_t cat, char *buf, size_t len);
+
+/* Both lines back to back in one buffer the caller keeps between saves */
+typedef struct {
+    char *buf;
+    size_t cap;
+    const char *interface_line; /* point into buf */
+    const char *ext_line;
+} cfg_lines_t;
 
+/* Render st into out, growing out->buf only when it is too small.
+ * Returns 0, or -1 on OOM (the lines are then undefined). */
+int  cfg_state_render(const cfg_state_t *st, cfg_lines_t *out);
+void cfg_lines_free(cfg_lines_t *l);
@@ -0,0 +1,661 @@
+/*
+ * srgn_configd [--uenv PATH] [--socket PATH] [--device REV[:SCREEN]]
+ * srgn_configd [--socket PATH] --query CMD...
+ *
+ * The second form sends the commands as one batch and prints the answers
+ * (exit 0 if all are "ok", 3 if not, 2 if the daemon is unreachable).
+ * See configd.h for the protocol.
+ */
+
+#define _GNU_SOURCE
+#include "configd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+#include "devcfg.h"
+#include "device.h"
+#include "filter.h"
+#include "overlay_pins.h"
+#include "uenv.h"
+#include "uenv_watch.h"
+
+#define MAX_EVENTS 32
+
+typedef enum {
+    SRC_LISTEN,
+    SRC_UENV_WATCH,
+    SRC_DEV_WATCH,
+    SRC_CLIENT,
+} src_kind_t;
+
+/* epoll data.ptr points at one of these (first member of client_t) */
+typedef struct {
+    src_kind_t kind;
+    int fd;
+} src_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+} buf_t;
+
+typedef struct {
+    src_t src;
+    buf_t in;
+    buf_t out;
+    size_t out_off;     /* bytes of out already sent */
+} client_t;
+
+typedef struct {
+    const char *uenv_path;
+    const device_provider_t *const *providers;
+    size_t provider_count;
+
+    int dev_status;
+    device_info_t dev;
+    char dev_err[160];
+
+    overlay_view_t view; /* registry, with pins from the overlays next to uEnv.txt */
+    int st_status;      /* 0, or -1 with st_err set (uEnv.txt unreadable) */
+    char st_err[256];
+    uenv_file_t u;
+    cfg_state_t st;
+    cfg_lines_t lines;  /* st rendered */
+    uint64_t gen;
+
+    int ep;
+    src_t listen;
+    uenv_watch_t uenv_watch;
+    uenv_watch_t dev_watch;
+    src_t uenv_src;
+    src_t dev_src;
+} configd_t;
+
+static volatile sig_atomic_t s_stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    s_stop = 1;
+}
+
+static int buf_reserve(buf_t *b, size_t more) {
+    if (b->len + more <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 1024;
+    while (cap < b->len + more) cap *= 2;
+    uint8_t *p = realloc(b->buf, cap);
+    if (!p) return -1;
+    b->buf = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int buf_add(buf_t *b, const void *data, size_t len) {
+    if (buf_reserve(b, len) != 0) return -1;
+    memcpy(b->buf + b->len, data, len);
+    b->len += len;
+    return 0;
+}
+
+static int buf_printf(buf_t *b, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+static int buf_printf(buf_t *b, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (n < 0 || buf_reserve(b, (size_t)n + 1) != 0) return -1;
+    va_start(ap, fmt);
+    vsnprintf((char *)b->buf + b->len, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    b->len += (size_t)n;
+    return 0;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* ---- state ---- */
+
+static void probe_device(configd_t *d) {
+    d->dev_status = device_info_probe(d->providers, d->provider_count, &d->dev, NULL, d->dev_err, sizeof(d->dev_err));
+    if (d->dev_status != 0 && !d->dev_err[0]) snprintf(d->dev_err, sizeof(d->dev_err), "device identity unknown");
+}
+
+static void drop_state(configd_t *d) {
+    if (d->st_status == 0) {
+        cfg_state_free(&d->st);
+        uenv_free(&d->u);
+    }
+    d->st_status = -1;
+}
+
+/* Re-read uEnv.txt; the state needs the revision, so a device failure counts too */
+static void load_state(configd_t *d) {
+    drop_state(d);
+    d->gen++;
+    if (d->dev_status != 0) {
+        snprintf(d->st_err, sizeof(d->st_err), "%s", d->dev_err);
+        return;
+    }
+    if (uenv_load(d->uenv_path, &d->u, d->st_err, sizeof(d->st_err)) != 0) return;
+    /* st is gone, so the registry may be rebuilt under it (overlays or revision changed) */
+    (void)overlay_view_refresh(&d->view, d->dev.rev);
+    if (cfg_state_init_from_uenv(&d->st, overlay_view_registry(&d->view), &d->u, d->dev.rev) != 0) {
+        uenv_free(&d->u);
+        snprintf(d->st_err, sizeof(d->st_err), "failed to initialize config state");
+        return;
+    }
+    if (cfg_state_render(&d->st, &d->lines) != 0) {
+        cfg_state_free(&d->st);
+        uenv_free(&d->u);
+        snprintf(d->st_err, sizeof(d->st_err), "out of memory");
+        return;
+    }
+    d->st_status = 0;
+}
+
+/* Put st back to what uEnv.txt holds after a rejected edit */
+static void reset_state(configd_t *d) {
+    cfg_state_t st;
+    if (cfg_state_init_from_uenv(&st, d->st.reg, &d->u, d->dev.rev) != 0) {
+        load_state(d);
+        return;
+    }
+    cfg_state_free(&d->st);
+    d->st = st;
+}
+
+static const char *enum_name(const devcfg_enum_t *table, size_t n, int value) {
+    for (size_t i = 0; i < n; i++) {
+        if (table[i].value == value) return table[i].name;
+    }
+    return "?";
+}
+
+/* Line tokens without "interface=" and the newline */
+static void add_tokens(buf_t *out, const char *line) {
+    const char *eq = strchr(line, '=');
+    const char *v = eq ? eq + 1 : line;
+    const size_t n = strcspn(v, "\n");
+    if (n) {
+        buf_add(out, " ", 1);
+        buf_add(out, v, n);
+    }
+}
+
+/* enable / disable / apply-profile */
+static void cmd_edit(configd_t *d, buf_t *out, const char *verb, const char *arg, bool force) {
+    /* a foreign write may still be queued; editing the old baseline would write over it */
+    if (uenv_watch_changed(&d->uenv_watch)) {
+        load_state(d);
+        if (d->st_status != 0) {
+            buf_printf(out, "err %s\n", d->st_err);
+            return;
+        }
+    }
+
+    filter_op_t op = {.enable = strcmp(verb, "enable") == 0, .id = arg};
+    filter_opts_t o = {.rev = d->dev.rev, .have_rev = true, .force = force};
+    if (strcmp(verb, "apply-profile") == 0) {
+        o.profile = arg;
+    } else {
+        o.ops = &op;
+        o.op_count = 1;
+    }
+
+    char err[256];
+    if (filter_apply_ops(&d->st, &o, force ? filter_confirm_force : filter_confirm_strict, NULL, err,
+                         sizeof(err)) != 0 ||
+        cfg_state_validate(&d->st, d->dev.rev, err, sizeof(err)) != 0) {
+        buf_printf(out, "err %s\n", err);
+        reset_state(d);
+        return;
+    }
+
+    cfg_lines_t next = {0};
+    if (cfg_state_render(&d->st, &next) != 0) {
+        buf_printf(out, "err out of memory\n");
+        reset_state(d);
+        return;
+    }
+    if (strcmp(next.interface_line, d->lines.interface_line) == 0 && strcmp(next.ext_line, d->lines.ext_line) == 0) {
+        cfg_lines_free(&next);
+        buf_printf(out, "ok unchanged\n");
+        return;
+    }
+    if (uenv_write_preserve(d->uenv_path, &d->u, next.interface_line, next.ext_line, err, sizeof(err)) != 0) {
+        cfg_lines_free(&next);
+        buf_printf(out, "err write failed: %s\n", err);
+        reset_state(d);
+        return;
+    }
+    cfg_lines_free(&next);
+    /* our own rename() shows up as an event; reloading here covers it, along
+     * with anything written after it */
+    (void)uenv_watch_changed(&d->uenv_watch);
+    load_state(d);
+    buf_printf(out, "ok changed\n");
+}
+
+static void run_command(configd_t *d, char *line, buf_t *out) {
+    char *argv[4] = {0};
+    int argc = 0;
+    for (char *tok = strtok(line, " \t\r"); tok && argc < 4; tok = strtok(NULL, " \t\r")) argv[argc++] = tok;
+    if (argc == 0) {
+        buf_printf(out, "err empty command\n");
+        return;
+    }
+    const char *cmd = argv[0];
+
+    if (strcmp(cmd, "ping") == 0) {
+        buf_printf(out, "ok\n");
+        return;
+    }
+    if (strcmp(cmd, "gen") == 0) {
+        buf_printf(out, "ok %llu\n", (unsigned long long)d->gen);
+        return;
+    }
+    if (strcmp(cmd, "reload") == 0) {
+        probe_device(d);
+        load_state(d);
+        if (d->st_status == 0) {
+            buf_printf(out, "ok\n");
+        } else {
+            buf_printf(out, "err %s\n", d->st_err);
+        }
+        return;
+    }
+    if (strcmp(cmd, "device") == 0) {
+        if (d->dev_status != 0) {
+            buf_printf(out, "err %s\n", d->dev_err);
+        } else {
+            buf_printf(out, "ok rev=%s screen=%s\n", enum_name(DEVCFG_REVS, DEVCFG_REV_COUNT, (int)d->dev.rev),
+                       enum_name(DEVCFG_SCREENS, DEVCFG_SCREEN_COUNT, (int)d->dev.screen));
+        }
+        return;
+    }
+
+    if (d->st_status != 0) {
+        buf_printf(out, "err %s\n", d->st_err);
+        return;
+    }
+    const cfg_registry_t *reg = d->st.reg;
+
+    if (strcmp(cmd, "get") == 0 && argc == 2) {
+        const int idx = cfg_registry_find(reg, argv[1]);
+        if (idx >= 0) {
+            buf_printf(out, "ok %d\n", cfg_state_is_enabled(&d->st, (size_t)idx) ? 1 : 0);
+        } else if (cfg_intern_find(&d->st.unknown_interface, argv[1]) != CFG_INTERN_NONE ||
+                   cfg_intern_find(&d->st.unknown_ext, argv[1]) != CFG_INTERN_NONE) {
+            buf_printf(out, "ok 1\n");
+        } else {
+            buf_printf(out, "err unknown item '%s'\n", argv[1]);
+        }
+    } else if (strcmp(cmd, "list") == 0 && argc == 1) {
+        buf_printf(out, "ok");
+        for (size_t i = 0; i < reg->count; i++) {
+            const cfg_item_t *it = &reg->items[i];
+            buf_printf(out, " %s=%s", it->id,
+                       cfg_state_is_enabled(&d->st, i) ? "enabled"
+                       : cfg_item_is_available(it, d->dev.rev) ? "disabled" : "unavailable");
+        }
+        buf_printf(out, "\n");
+    } else if ((strcmp(cmd, "interface") == 0 || strcmp(cmd, "ext") == 0) && argc == 1) {
+        buf_printf(out, "ok");
+        add_tokens(out, cmd[0] == 'i' ? d->lines.interface_line : d->lines.ext_line);
+        buf_printf(out, "\n");
+    } else if (strcmp(cmd, "validate") == 0 && argc == 1) {
+        char err[256];
+        if (cfg_state_validate(&d->st, d->dev.rev, err, sizeof(err)) == 0) {
+            buf_printf(out, "ok\n");
+        } else {
+            buf_printf(out, "err %s\n", err);
+        }
+    } else if ((strcmp(cmd, "enable") == 0 || strcmp(cmd, "disable") == 0 || strcmp(cmd, "apply-profile") == 0) &&
+               (argc == 2 || (argc == 3 && strcmp(argv[2], "force") == 0))) {
+        cmd_edit(d, out, cmd, argv[1], argc == 3);
+    } else {
+        buf_printf(out, "err bad command '%s'\n", cmd);
+    }
+}
+
+/* ---- connections ---- */
+
+static void client_close(configd_t *d, client_t *c) {
+    epoll_ctl(d->ep, EPOLL_CTL_DEL, c->src.fd, NULL);
+    close(c->src.fd);
+    free(c->in.buf);
+    free(c->out.buf);
+    free(c);
+}
+
+static void client_events(configd_t *d, client_t *c, uint32_t events) {
+    struct epoll_event ev = {.events = events, .data.ptr = c};
+    epoll_ctl(d->ep, EPOLL_CTL_MOD, c->src.fd, &ev);
+}
+
+/* Answer every complete frame in c->in. -1 closes the connection. */
+static int client_process(configd_t *d, client_t *c) {
+    size_t pos = 0;
+    while (c->in.len - pos >= 4) {
+        const uint32_t len = get_u32(c->in.buf + pos);
+        if (len > CONFIGD_FRAME_MAX) return -1;
+        if (c->in.len - pos - 4 < len) break;
+
+        char *req = (char *)c->in.buf + pos + 4;
+        const size_t hdr = c->out.len;
+        const uint8_t zero[4] = {0};
+        if (buf_add(&c->out, zero, 4) != 0) return -1;
+        /* commands are split in place; the frame is consumed afterwards */
+        const char saved = req[len];
+        req[len] = 0;
+        for (char *line = req, *next; line; line = next) {
+            next = strchr(line, '\n');
+            if (next) *next++ = 0;
+            if (!line[0] && !next) break; /* trailing newline */
+            run_command(d, line, &c->out);
+        }
+        req[len] = saved;
+        put_u32(c->out.buf + hdr, (uint32_t)(c->out.len - hdr - 4));
+        pos += 4 + len;
+    }
+    memmove(c->in.buf, c->in.buf + pos, c->in.len - pos);
+    c->in.len -= pos;
+    return 0;
+}
+
+/* -1: connection broken; otherwise 1 if output is still pending */
+static int client_flush(client_t *c) {
+    while (c->out_off < c->out.len) {
+        const ssize_t n = send(c->src.fd, c->out.buf + c->out_off, c->out.len - c->out_off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+        if (n <= 0) return -1;
+        c->out_off += (size_t)n;
+    }
+    c->out.len = c->out_off = 0;
+    return 0;
+}
+
+static void client_ready(configd_t *d, client_t *c, uint32_t events) {
+    if (events & EPOLLIN) {
+        for (;;) {
+            /* one extra byte so client_process can terminate a full frame in place */
+            if (buf_reserve(&c->in, 4097) != 0) {
+                client_close(d, c);
+                return;
+            }
+            const ssize_t n = recv(c->src.fd, c->in.buf + c->in.len, c->in.cap - c->in.len - 1, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) {
+                client_close(d, c);
+                return;
+            }
+            c->in.len += (size_t)n;
+        }
+        if (client_process(d, c) != 0) {
+            client_close(d, c);
+            return;
+        }
+    } else if (events & (EPOLLHUP | EPOLLERR)) {
+        client_close(d, c);
+        return;
+    }
+
+    const int r = client_flush(c);
+    if (r < 0) {
+        client_close(d, c);
+    } else {
+        /* stop reading while answers are pending: a client that doesn't read can't pile up work */
+        client_events(d, c, r ? EPOLLOUT : EPOLLIN);
+    }
+}
+
+static void accept_clients(configd_t *d) {
+    for (;;) {
+        const int fd = accept4(d->listen.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        client_t *c = calloc(1, sizeof(*c));
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        if (!c || epoll_ctl(d->ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->src.kind = SRC_CLIENT;
+        c->src.fd = fd;
+    }
+}
+
+static int open_socket(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "srgn_configd: socket path too long\n");
+        return -1;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    char dir[sizeof(addr.sun_path)];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash && slash != dir) {
+        *slash = 0;
+        (void)mkdir(dir, 0755);
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    (void)unlink(path); /* left over from a previous run */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || chmod(path, 0660) != 0 || listen(fd, 16) != 0) {
+        fprintf(stderr, "srgn_configd: %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static const char *socket_path(const char *arg) {
+    if (arg) return arg;
+    const char *env = getenv("SRGN_CONFIGD_SOCKET");
+    return (env && env[0]) ? env : CONFIGD_SOCKET;
+}
+
+static void watch_add(configd_t *d, uenv_watch_t *w, src_t *src, src_kind_t kind) {
+    src->kind = kind;
+    src->fd = w->fd;
+    if (w->fd < 0) return;
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = src};
+    epoll_ctl(d->ep, EPOLL_CTL_ADD, w->fd, &ev);
+}
+
+static int serve(const char *uenv_path, const char *sock, const char *device) {
+    configd_t d;
+    memset(&d, 0, sizeof(d));
+    d.uenv_path = uenv_path;
+    d.st_status = -1;
+    const device_provider_t override = {"override", device_provider_override_get, device};
+    const device_provider_t *const providers[] = {&override, &DEVICE_PROVIDER_ENV, &DEVICE_PROVIDER_CACHE,
+                                                  &DEVICE_PROVIDER_MTD};
+    d.providers = providers;
+    d.provider_count = sizeof(providers) / sizeof(providers[0]);
+
+    probe_device(&d);
+    if (overlay_view_scan(&d.view, uenv_path) != 0) {
+        fprintf(stderr, "srgn_configd: no usable registry\n");
+        return 2;
+    }
+    load_state(&d);
+    if (d.st_status != 0) fprintf(stderr, "srgn_configd: %s (serving errors until it is fixed)\n", d.st_err);
+
+    d.ep = epoll_create1(EPOLL_CLOEXEC);
+    d.listen.kind = SRC_LISTEN;
+    d.listen.fd = open_socket(sock);
+    if (d.ep < 0 || d.listen.fd < 0) {
+        if (d.ep >= 0) close(d.ep);
+        drop_state(&d);
+        overlay_view_free(&d.view);
+        cfg_lines_free(&d.lines);
+        return 2;
+    }
+    struct epoll_event lev = {.events = EPOLLIN, .data.ptr = &d.listen};
+    epoll_ctl(d.ep, EPOLL_CTL_ADD, d.listen.fd, &lev);
+
+    /* without inotify answers may go stale until "reload" */
+    (void)uenv_watch_open(&d.uenv_watch, uenv_path);
+    watch_add(&d, &d.uenv_watch, &d.uenv_src, SRC_UENV_WATCH);
+    char cache[512];
+    device_info_cache_path(cache, sizeof(cache));
+    d.dev_watch.fd = -1;
+    if (cache[0]) (void)uenv_watch_open(&d.dev_watch, cache);
+    watch_add(&d, &d.dev_watch, &d.dev_src, SRC_DEV_WATCH);
+
+    struct sigaction sa = {.sa_handler = on_signal};
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!s_stop) {
+        const int n = epoll_wait(d.ep, events, MAX_EVENTS, -1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;
+        for (int i = 0; i < n; i++) {
+            src_t *src = events[i].data.ptr;
+            switch (src->kind) {
+                case SRC_LISTEN:
+                    accept_clients(&d);
+                    break;
+                case SRC_UENV_WATCH:
+                    if (uenv_watch_changed(&d.uenv_watch)) load_state(&d);
+                    break;
+                case SRC_DEV_WATCH:
+                    /* the identity cache was rewritten or dropped (devcfg edited) */
+                    if (uenv_watch_changed(&d.dev_watch)) {
+                        const device_info_t old = d.dev;
+                        const int old_status = d.dev_status;
+                        probe_device(&d);
+                        if (d.dev_status != old_status || d.dev.rev != old.rev || d.dev.screen != old.screen) {
+                            load_state(&d);
+                        }
+                    }
+                    break;
+                case SRC_CLIENT:
+                    client_ready(&d, (client_t *)src, events[i].events);
+                    break;
+            }
+        }
+    }
+
+    /* clients are freed by the OS at exit; only the socket file needs cleanup */
+    unlink(sock);
+    close(d.listen.fd);
+    uenv_watch_close(&d.uenv_watch);
+    uenv_watch_close(&d.dev_watch);
+    close(d.ep);
+    drop_state(&d);
+    overlay_view_free(&d.view);
+    cfg_lines_free(&d.lines);
+    return 0;
+}
+
+/* ---- client ---- */
+
+static int io_all(int fd, void *buf, size_t len, bool write_it) {
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = write_it ? send(fd, (const char *)buf + done, len - done, MSG_NOSIGNAL)
+                                   : recv(fd, (char *)buf + done, len - done, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int query(const char *sock, int argc, char **argv) {
+    buf_t req = {0};
+    const uint8_t zero[4] = {0};
+    int ret = 2;
+    buf_add(&req, zero, 4);
+    for (int i = 0; i < argc; i++) buf_printf(&req, "%s\n", argv[i]);
+    if (!req.buf || req.len - 4 > CONFIGD_FRAME_MAX) {
+        fprintf(stderr, "srgn_configd: request too large\n");
+        free(req.buf);
+        return 1;
+    }
+    put_u32(req.buf, (uint32_t)(req.len - 4));
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", sock);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    uint8_t hdr[4];
+    char *resp = NULL;
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "srgn_configd: cannot connect to %s: %s\n", sock, strerror(errno));
+    } else if (io_all(fd, req.buf, req.len, true) != 0 || io_all(fd, hdr, 4, false) != 0 ||
+               get_u32(hdr) > (uint32_t)CONFIGD_FRAME_MAX * 16 || !(resp = malloc(get_u32(hdr) + 1)) ||
+               io_all(fd, resp, get_u32(hdr), false) != 0) {
+        fprintf(stderr, "srgn_configd: connection to %s failed\n", sock);
+    } else {
+        resp[get_u32(hdr)] = 0;
+        fputs(resp, stdout);
+        ret = 0;
+        for (const char *line = resp; *line; line = strchr(line, '\n') + 1) {
+            if (strncmp(line, "ok", 2) != 0) ret = 3;
+            if (!strchr(line, '\n')) break;
+        }
+    }
+    if (fd >= 0) close(fd);
+    free(resp);
+    free(req.buf);
+    return ret;
+}
+
+int main(int argc, char **argv) {
+    const char *env = getenv("SRGN_UENV_PATH");
+    const char *uenv_path = (env && env[0]) ? env : "/boot/uEnv.txt";
+    const char *sock = NULL;
+    const char *device = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--uenv") == 0 && (i + 1) < argc) {
+            uenv_path = argv[++i];
+        } else if (strcmp(argv[i], "--socket") == 0 && (i + 1) < argc) {
+            sock = argv[++i];
+        } else if (strcmp(argv[i], "--device") == 0 && (i + 1) < argc) {
+            device = argv[++i];
+        } else if (strcmp(argv[i], "--query") == 0 && (i + 1) < argc) {
+            return query(socket_path(sock), argc - i - 1, argv + i + 1);
+        } else {
+            fprintf(stderr,
+                    "usage: srgn_configd [--uenv PATH] [--socket PATH] [--device REV[:SCREEN]]\n"
+                    "       srgn_configd [--socket PATH] --query CMD...\n");
+            return 1;
+        }
+    }
+    return serve(uenv_path, socket_path(sock), device);
+}
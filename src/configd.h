@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+ * srgn_configd: resident configuration daemon.
+ *
+ * Keeps the parsed uEnv.txt, its cfg_state_t and the device identity in
+ * memory and answers queries over a UNIX stream socket, so other components
+ * don't re-read uEnv.txt or flash. inotify on uEnv.txt (and on the identity
+ * cache, which `srgn_config --devcfg` removes) triggers a reload. Edits are
+ * applied and written by the daemon alone, one at a time.
+ *
+ * Framing, both directions: u32 little-endian payload length, then payload.
+ * A request payload is one or more commands separated by '\n'; the response
+ * has one line per command, in order, starting with "ok" or "err":
+ *
+ *   ping                          ok
+ *   gen                           ok N (bumped by every reload and write)
+ *   device                        ok rev=0.5 screen=hsd
+ *   get ID                        ok 1 | ok 0
+ *   list                          ok ID=enabled|disabled|unavailable ...
+ *   interface | ext               ok TOKEN ... (the line's tokens, unknown ones included)
+ *   validate                      ok | err REASON
+ *   enable ID [force]             ok changed | ok unchanged | err REASON
+ *   disable ID [force]            same
+ *   apply-profile NAME|CODE [force]
+ *   reload                        ok
+ *
+ * A frame over CONFIGD_FRAME_MAX closes the connection.
+ */
+
+#define CONFIGD_FRAME_MAX (64 * 1024)
+#define CONFIGD_SOCKET    "/run/srgn_config/configd.sock" /* $SRGN_CONFIGD_SOCKET overrides */
@@ -0,0 +1,181 @@
+#include "devcfg.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const devcfg_enum_t DEVCFG_REVS[] = {
+    {"0.2", DEVICE_REV_EPASS_0_2},
+    {"0.3", DEVICE_REV_EPASS_0_3_0_4},
+    {"0.4", DEVICE_REV_EPASS_0_3_0_4},
+    {"0.5", DEVICE_REV_EPASS_0_5},
+    {"0.6", DEVICE_REV_EPASS_0_6},
+};
+const size_t DEVCFG_REV_COUNT = sizeof(DEVCFG_REVS) / sizeof(DEVCFG_REVS[0]);
+
+const devcfg_enum_t DEVCFG_SCREENS[] = {
+    {"hsd", DEVICE_SCREEN_360640_HSD},
+    {"boe", DEVICE_SCREEN_360640_BOE},
+    {"laowu", DEVICE_SCREEN_360640_LAOWU},
+};
+const size_t DEVCFG_SCREEN_COUNT = sizeof(DEVCFG_SCREENS) / sizeof(DEVCFG_SCREENS[0]);
+
+static bool key_char(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+int devcfg_parse(devcfg_t *c, const void *block, size_t len) {
+    if (!c || !block || len > UINT16_MAX) return -1;
+    memset(c, 0, sizeof(*c));
+    c->text = malloc(len + 1);
+    if (!c->text) return -1;
+    memcpy(c->text, block, len);
+    c->text[len] = 0;
+    c->size = len;
+
+    const char *end = memchr(c->text, 0, len);
+    const char *erased = memchr(c->text, 0xFF, len);
+    c->used = (size_t)((end ? end : c->text + len) - c->text);
+    if (erased && (size_t)(erased - c->text) < c->used) c->used = (size_t)(erased - c->text);
+
+    for (size_t pos = 0; pos < c->used;) {
+        char *line = c->text + pos;
+        const char *nl = memchr(line, '\n', c->used - pos);
+        size_t line_len = nl ? (size_t)(nl - line) : c->used - pos;
+        const size_t next = pos + line_len + (nl ? 1 : 0);
+        if (line_len && line[line_len - 1] == '\r') line_len--;
+
+        size_t k = 0;
+        while (k < line_len && key_char(line[k])) k++;
+        if (k > 0 && k < DEVCFG_KEY_MAX && k < line_len && line[k] == '=' && c->count < DEVCFG_MAX_FIELDS) {
+            line[k] = 0;
+            if (!devcfg_get(c, line)) {
+                size_t v = k + 1;
+                size_t v_end = line_len;
+                while (v < v_end && (line[v] == ' ' || line[v] == '\t')) v++;
+                while (v_end > v && (line[v_end - 1] == ' ' || line[v_end - 1] == '\t')) v_end--;
+                devcfg_field_t *f = &c->fields[c->count++];
+                f->line = (uint16_t)pos;
+                f->line_len = (uint16_t)line_len;
+                f->value = (uint16_t)(pos + v);
+                f->value_len = (uint16_t)(v_end - v);
+                line[v_end] = 0; /* the newline, '\r' or trailing blank; the block copy has room */
+            }
+        }
+        pos = next;
+    }
+    return 0;
+}
+
+void devcfg_free(devcfg_t *c) {
+    if (!c) return;
+    free(c->text);
+    memset(c, 0, sizeof(*c));
+}
+
+const char *devcfg_key(const devcfg_t *c, size_t i) {
+    return c->text + c->fields[i].line;
+}
+
+const char *devcfg_value(const devcfg_t *c, size_t i) {
+    return c->text + c->fields[i].value;
+}
+
+const char *devcfg_get(const devcfg_t *c, const char *key) {
+    if (!c || !key) return NULL;
+    for (size_t i = 0; i < c->count; i++) {
+        if (strcmp(devcfg_key(c, i), key) == 0) return devcfg_value(c, i);
+    }
+    return NULL;
+}
+
+int devcfg_get_enum(const devcfg_t *c, const char *key, const devcfg_enum_t *table, size_t n, int *out) {
+    const char *v = devcfg_get(c, key);
+    if (!v) return -1;
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(v, table[i].name) == 0) {
+            *out = table[i].value;
+            return 0;
+        }
+    }
+    return -2;
+}
+
+static int get_field(const devcfg_t *c, const char *key, const devcfg_enum_t *table, size_t n, int *out, char *err,
+                     size_t err_len) {
+    const int r = devcfg_get_enum(c, key, table, n, out);
+    if (r == -1 && err && err_len) snprintf(err, err_len, "%s not found", key);
+    if (r == -2 && err && err_len) snprintf(err, err_len, "%s=%s is unknown", key, devcfg_get(c, key));
+    return r;
+}
+
+int devcfg_device_info(const devcfg_t *c, device_info_t *info, char *err, size_t err_len) {
+    if (!c || !info) return -1;
+    int rev = 0, screen = 0;
+    if (get_field(c, "device_rev", DEVCFG_REVS, DEVCFG_REV_COUNT, &rev, err, err_len) != 0) return -1;
+    if (get_field(c, "screen", DEVCFG_SCREENS, DEVCFG_SCREEN_COUNT, &screen, err, err_len) != 0) return -1;
+    info->rev = (device_rev_t)rev;
+    info->screen = (device_screen_t)screen;
+    return 0;
+}
+
+static int set_fail(char *err, size_t err_len, const char *msg, const char *key) {
+    if (err && err_len) snprintf(err, err_len, "%s: %s", key, msg);
+    return -1;
+}
+
+int devcfg_set(const devcfg_t *c, const void *raw, const char *key, const char *value, void *out, char *err,
+               size_t err_len) {
+    if (!c || !raw || !key || !value || !out) return -1;
+    const size_t key_len = strlen(key);
+    const size_t value_len = strlen(value);
+    if (key_len == 0 || key_len >= DEVCFG_KEY_MAX) return set_fail(err, err_len, "invalid key", key);
+    for (size_t i = 0; i < key_len; i++) {
+        if (!key_char(key[i])) return set_fail(err, err_len, "invalid key", key);
+    }
+    for (size_t i = 0; i < value_len; i++) {
+        const unsigned char ch = (unsigned char)value[i];
+        if (ch < 0x20 || ch == 0x7F || ch == 0xFF) return set_fail(err, err_len, "value has control characters", key);
+    }
+
+    const uint8_t *src = raw;
+    uint8_t *dst = out;
+    const uint8_t term = c->used < c->size ? src[c->used] : 0;
+    memcpy(dst, src, c->size);
+
+    /* [at, at + old_len) of the used text is replaced by ins_len new bytes */
+    size_t at = c->used, old_len = 0, ins_len;
+    size_t i;
+    for (i = 0; i < c->count; i++) {
+        if (strcmp(devcfg_key(c, i), key) == 0) break;
+    }
+    const bool found = i < c->count;
+    const bool need_nl = !found && c->used > 0 && src[c->used - 1] != '\n';
+    if (found) {
+        at = c->fields[i].value;
+        old_len = c->fields[i].value_len;
+        ins_len = value_len;
+    } else {
+        ins_len = (need_nl ? 1 : 0) + key_len + 1 + value_len + 1;
+    }
+
+    const size_t new_used = c->used - old_len + ins_len; /* old_len <= used */
+    if (ins_len >= c->size || new_used >= c->size) return set_fail(err, err_len, "devcfg block is full", key);
+    memmove(dst + at + ins_len, src + at + old_len, c->used - at - old_len);
+    if (found) {
+        memcpy(dst + at, value, value_len);
+    } else {
+        uint8_t *p = dst + at;
+        if (need_nl) *p++ = '\n';
+        memcpy(p, key, key_len);
+        p[key_len] = '=';
+        memcpy(p + key_len + 1, value, value_len);
+        p[key_len + 1 + value_len] = '\n';
+    }
+    /* terminator, plus padding over whatever a shorter value left behind */
+    size_t pad_end = c->used > new_used + 1 ? c->used : new_used + 1;
+    if (pad_end > c->size) pad_end = c->size;
+    memset(dst + new_used, term, pad_end - new_used);
+    return 0;
+}
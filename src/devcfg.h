@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "device.h"
+
+/*
+ * devcfg block reader. The block is "key=value" lines, ended by the first
+ * NUL or erased (0xFF) byte. It is parsed once into a table of fields with
+ * explicit offsets into the block, so lookups never scan past its end and
+ * the writer (devcfg_set) can edit a value in place.
+ */
+
+#define DEVCFG_MAX_FIELDS 32
+#define DEVCFG_KEY_MAX    32
+
+typedef struct {
+    uint16_t line;      /* offset of the line in the block */
+    uint16_t line_len;  /* without the newline */
+    uint16_t value;     /* offset of the value in the block */
+    uint16_t value_len;
+} devcfg_field_t;
+
+typedef struct {
+    char *text;         /* copy of the block; key and value NUL-terminated in place */
+    size_t size;        /* block size */
+    size_t used;        /* bytes before the terminator */
+    size_t count;
+    devcfg_field_t fields[DEVCFG_MAX_FIELDS];
+} devcfg_t;
+
+typedef struct {
+    const char *name;
+    int value;
+} devcfg_enum_t;
+
+/* Parse len bytes of block. Malformed lines are skipped; a repeated key
+ * keeps its first value. Returns 0, or -1 on OOM or a block over 64 KiB. */
+int  devcfg_parse(devcfg_t *c, const void *block, size_t len);
+void devcfg_free(devcfg_t *c);
+
+/* Value of key, or NULL if the block has no such field */
+const char *devcfg_get(const devcfg_t *c, const char *key);
+const char *devcfg_key(const devcfg_t *c, size_t i);   /* i < c->count */
+const char *devcfg_value(const devcfg_t *c, size_t i);
+
+/* Map the value of key through table. Returns 0, -1 if the key is missing,
+ * -2 if the value is not in the table. */
+int devcfg_get_enum(const devcfg_t *c, const char *key, const devcfg_enum_t *table, size_t n, int *out);
+
+/* device_rev= and screen= */
+extern const devcfg_enum_t DEVCFG_REVS[];
+extern const size_t DEVCFG_REV_COUNT;
+extern const devcfg_enum_t DEVCFG_SCREENS[];
+extern const size_t DEVCFG_SCREEN_COUNT;
+
+/* Fill info from the fields; on failure err says which field is missing or unknown */
+int devcfg_device_info(const devcfg_t *c, device_info_t *info, char *err, size_t err_len);
+
+/* Build in out (c->size bytes) the block with key set to value: the value is
+ * replaced in place, or a "key=value" line is appended if the key is absent.
+ * raw is the block c was parsed from; everything outside the edit keeps its
+ * bytes and a shrunk line is padded with the terminator (NUL or 0xFF), so
+ * only the changed bytes differ. Returns 0, or -1 with err set (bad key or
+ * value, block full). */
+int devcfg_set(const devcfg_t *c, const void *raw, const char *key, const char *value, void *out, char *err,
+               size_t err_len);
@@ -0,0 +1,128 @@
+#include "devcfg_tool.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "devcfg.h"
+#include "device.h"
+#include "mtd.h"
+
+static void devcfg_usage(void) {
+    fprintf(stderr,
+            "usage: srgn_config --devcfg [--mtd PATH] [--dry-run] [KEY=VALUE]...\n"
+            "  device_rev: 0.2 0.3 0.4 0.5 0.6   screen: hsd boe laowu\n");
+}
+
+static bool enum_ok(const devcfg_enum_t *table, size_t n, const char *value) {
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(table[i].name, value) == 0) return true;
+    }
+    return false;
+}
+
+static void print_fields(const devcfg_t *c) {
+    for (size_t i = 0; i < c->count; i++) printf("%s=%s\n", devcfg_key(c, i), devcfg_value(c, i));
+}
+
+int devcfg_requested(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--devcfg") == 0) return 1;
+    }
+    return 0;
+}
+
+int devcfg_run(int argc, char **argv) {
+    const char *path = getenv("SRGN_MTD");
+    if (!path || !path[0]) path = DEVCFG_MTD;
+    bool dry_run = false;
+    int sets = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--devcfg") == 0) continue;
+        if (strcmp(argv[i], "--mtd") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        } else if (strcmp(argv[i], "--dry-run") == 0) {
+            dry_run = true;
+        } else if (argv[i][0] != '-' && strchr(argv[i], '=')) {
+            sets++;
+        } else {
+            devcfg_usage();
+            return 1;
+        }
+    }
+
+    char err[160];
+    mtd_dev_t m;
+    if (mtd_open(&m, path, sets > 0 && !dry_run, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: %s\n", err);
+        return 2;
+    }
+    uint8_t cur[DEVCFG_SIZE], next[DEVCFG_SIZE];
+    if (mtd_read(&m, DEVCFG_OFFSET, cur, sizeof(cur)) != 0) {
+        fprintf(stderr, "srgn_config: cannot read devcfg from %s\n", path);
+        mtd_close(&m);
+        return 2;
+    }
+
+    devcfg_t c;
+    if (devcfg_parse(&c, cur, sizeof(cur)) != 0) {
+        fprintf(stderr, "srgn_config: failed to parse devcfg\n");
+        mtd_close(&m);
+        return 2;
+    }
+    if (sets == 0) {
+        print_fields(&c);
+        devcfg_free(&c);
+        mtd_close(&m);
+        return 0;
+    }
+
+    /* each assignment edits the result of the previous one */
+    uint8_t orig[DEVCFG_SIZE];
+    memcpy(orig, cur, sizeof(cur));
+    int ret = 0;
+    for (int i = 1; i < argc && ret == 0; i++) {
+        if (strcmp(argv[i], "--mtd") == 0) {
+            i++;
+            continue;
+        }
+        char *eq = argv[i][0] != '-' ? strchr(argv[i], '=') : NULL;
+        if (!eq) continue;
+        *eq = 0;
+        const char *key = argv[i], *value = eq + 1;
+        if ((strcmp(key, "device_rev") == 0 && !enum_ok(DEVCFG_REVS, DEVCFG_REV_COUNT, value)) ||
+            (strcmp(key, "screen") == 0 && !enum_ok(DEVCFG_SCREENS, DEVCFG_SCREEN_COUNT, value))) {
+            fprintf(stderr, "srgn_config: unknown %s '%s'\n", key, value);
+            ret = 1;
+        } else if (devcfg_set(&c, cur, key, value, next, err, sizeof(err)) != 0) {
+            fprintf(stderr, "srgn_config: %s\n", err);
+            ret = 1;
+        } else {
+            memcpy(cur, next, sizeof(cur));
+            devcfg_free(&c);
+            if (devcfg_parse(&c, cur, sizeof(cur)) != 0) ret = 2;
+        }
+        *eq = '=';
+    }
+
+    if (ret == 0 && dry_run) {
+        print_fields(&c);
+    } else if (ret == 0 && memcmp(orig, cur, sizeof(cur)) == 0) {
+        fprintf(stderr, "srgn_config: devcfg unchanged\n");
+    } else if (ret == 0) {
+        mtd_update_stats_t stats;
+        if (mtd_update(&m, DEVCFG_OFFSET, cur, sizeof(cur), &stats, err, sizeof(err)) != 0) {
+            fprintf(stderr, "srgn_config: %s\n", err);
+            ret = 2;
+        } else {
+            fprintf(stderr, "srgn_config: devcfg written (%u erase block%s rewritten, %u erased)\n",
+                    stats.blocks_changed, stats.blocks_changed == 1 ? "" : "s", stats.blocks_erased);
+            device_info_invalidate();
+        }
+    }
+    devcfg_free(&c);
+    mtd_close(&m);
+    return ret;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * devcfg editor:
+ *   srgn_config --devcfg [--mtd PATH] [--dry-run] [KEY=VALUE]...
+ *
+ * Without assignments, prints the devcfg fields. Otherwise sets each KEY
+ * (device_rev and screen must name a known revision / panel) and writes the
+ * block back through the mtd char device, rewriting only the erase block
+ * that holds it, and only if its bytes changed. --mtd (default $SRGN_MTD, then
+ * /dev/mtd0) may name a regular file standing in for the flash (see mtd.h).
+ * --dry-run prints the result instead.
+ */
+
+int devcfg_requested(int argc, char **argv);
+
+/* Exit code: 0 ok, 1 usage / bad value, 2 device error */
+int devcfg_run(int argc, char **argv);
@@ -1,9 +1,21 @@
 #include "device.h"
+#include "devcfg.h"
+#include <errno.h>
+#include <stdbool.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <stdio.h>
 
+#ifndef SRGN_CACHE_DIR
+#define SRGN_CACHE_DIR "/run/srgn_config"
+#endif
+
+#define BOOT_ID_PATH      "/proc/sys/kernel/random/boot_id"
+#define DEVICE_CACHE_MAGIC   "srgn-device"
+#define DEVICE_CACHE_VERSION 1 /* bump when the layout below changes; other versions are misses */
 char* get_device_rev_str(device_rev_t rev) {
     switch (rev) {
         case DEVICE_REV_EPASS_0_2:
@@ -30,52 +42,204 @@ char* get_device_screen_str(device_screen_t screen) {
     return "Unknown";
 }
 
-int get_device_info(device_info_t *info){
-    int fd = open("/dev/mtdblock0", O_RDONLY);
-    char buf[1024];
-    if (fd == -1) {
+int device_rev_from_str(const char *s, device_rev_t *out) {
+    if (!s || !out) return -1;
+    if (strncmp(s, "0.2", 3) == 0) {
+        *out = DEVICE_REV_EPASS_0_2;
+    } else if (strncmp(s, "0.3", 3) == 0 || strncmp(s, "0.4", 3) == 0) {
+        *out = DEVICE_REV_EPASS_0_3_0_4;
+    } else if (strncmp(s, "0.5", 3) == 0) {
+        *out = DEVICE_REV_EPASS_0_5;
+    } else if (strncmp(s, "0.6", 3) == 0) {
+        *out = DEVICE_REV_EPASS_0_6;
+    } else {
         return -1;
     }
+    return 0;
+}
 
-    lseek(fd, DEVCFG_OFFSET, SEEK_SET);
-    read(fd, buf, 1024);
-
-    char *device_rev = strstr(buf, "device_rev=");
-    char *screen = strstr(buf, "screen=");
-    if (device_rev) {
-        device_rev += strlen("device_rev=");
-        if (strncmp(device_rev, "0.2", 3) == 0) {
-            info->rev = DEVICE_REV_EPASS_0_2;
-        } else if (strncmp(device_rev, "0.3", 3) == 0) {
-            info->rev = DEVICE_REV_EPASS_0_3_0_4;
-        } else if (strncmp(device_rev, "0.5", 3) == 0) {
-            info->rev = DEVICE_REV_EPASS_0_5;
-        } else if (strncmp(device_rev, "0.6", 3) == 0) {
-            info->rev = DEVICE_REV_EPASS_0_6;
+int device_info_from_str(const char *s, device_info_t *info) {
+    if (!s || !info) return -1;
+    device_info_t out = {.screen = DEVICE_SCREEN_360640_HSD};
+    const char *colon = strchr(s, ':');
+    if (device_rev_from_str(s, &out.rev) != 0) return -1;
+    if (colon) {
+        size_t i;
+        for (i = 0; i < DEVCFG_SCREEN_COUNT; i++) {
+            if (strcmp(colon + 1, DEVCFG_SCREENS[i].name) == 0) break;
         }
+        if (i == DEVCFG_SCREEN_COUNT) return -1;
+        out.screen = (device_screen_t)DEVCFG_SCREENS[i].value;
     }
-    else{
-        printf("device_rev not found\n");
-        close(fd);
+    *info = out;
+    return 0;
+}
+
+static int read_devcfg(const char *image, char *buf, size_t len) {
+    int fd = open(image ? image : DEVCFG_MTD, O_RDONLY | O_CLOEXEC);
+    if (fd == -1 && !image) fd = open(DEVCFG_MTDBLOCK, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
         return -1;
     }
+    size_t got = 0;
+    while (got < len) {
+        const ssize_t n = pread(fd, buf + got, len - got, (off_t)DEVCFG_OFFSET + (off_t)got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    return got == len ? 0 : -1;
+}
 
-    if (screen) {
-        screen += strlen("screen=");
-        if (strncmp(screen, "hsd", 3) == 0) {
-            info->screen = DEVICE_SCREEN_360640_HSD;
-        } else if (strncmp(screen, "boe", 3) == 0) {
-            info->screen = DEVICE_SCREEN_360640_BOE;
-        } else if (strncmp(screen, "laowu", 5) == 0) {
-            info->screen = DEVICE_SCREEN_360640_LAOWU;
-        }
+/* ---- identity cache ---- */
+
+void device_info_cache_path(char *buf, size_t len) {
+    const char *dir = getenv("SRGN_CACHE_DIR");
+    if (!dir) dir = SRGN_CACHE_DIR;
+    if (!dir[0]) {
+        buf[0] = 0; /* caching disabled */
+        return;
+    }
+    snprintf(buf, len, "%s/device", dir);
+}
+
+static int read_boot_id(char *buf, size_t len) {
+    FILE *fp = fopen(BOOT_ID_PATH, "r");
+    if (!fp) return -1;
+    const bool ok = fgets(buf, (int)len, fp) != NULL;
+    fclose(fp);
+    if (!ok) return -1;
+    buf[strcspn(buf, "\n")] = 0;
+    return buf[0] ? 0 : -1;
+}
+
+static int cache_load(const char *path, const char *boot_id, device_info_t *info) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    char magic[32], id[64];
+    int version = -1, rev = -1, screen = -1;
+    const int n = fscanf(fp, "%31s %d\nboot_id %63s\nrev %d\nscreen %d", magic, &version, id, &rev, &screen);
+    fclose(fp);
+    if (n != 5 || strcmp(magic, DEVICE_CACHE_MAGIC) != 0 || version != DEVICE_CACHE_VERSION) return -1;
+    if (strcmp(id, boot_id) != 0) return -1;
+    if (rev < DEVICE_REV_EPASS_0_2 || rev > DEVICE_REV_EPASS_0_6) return -1;
+    if (screen < DEVICE_SCREEN_360640_HSD || screen > DEVICE_SCREEN_360640_LAOWU) return -1;
+    info->rev = (device_rev_t)rev;
+    info->screen = (device_screen_t)screen;
+    return 0;
+}
+
+/* Best effort: without a cache the next launch just reads flash again */
+static void cache_store(const char *path, const char *boot_id, const device_info_t *info) {
+    char dir[512];
+    char tmp[520];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        *slash = 0;
+        (void)mkdir(dir, 0755);
     }
-    else{
-        printf("screen not found\n");
-        close(fd);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) return;
+    fprintf(fp, DEVICE_CACHE_MAGIC " %d\nboot_id %s\nrev %d\nscreen %d\n", DEVICE_CACHE_VERSION, boot_id, (int)info->rev,
+            (int)info->screen);
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+/* ---- providers ---- */
+
+static void set_err(char *err, size_t err_len, const char *msg, const char *what) {
+    if (err && err_len) snprintf(err, err_len, "%s: %s", what, msg);
+}
+
+int device_provider_override_get(const device_provider_t *p, device_info_t *info, char *err, size_t err_len) {
+    if (!p->arg) return -1;
+    if (device_info_from_str(p->arg, info) != 0) {
+        set_err(err, err_len, "expected REV[:SCREEN]", p->arg);
         return -1;
     }
-    
-    close(fd);
     return 0;
 }
+
+static int env_get(const device_provider_t *p, device_info_t *info, char *err, size_t err_len) {
+    const char *env = getenv("SRGN_DEVICE");
+    if (!env || !env[0]) return -1;
+    const device_provider_t from_env = {p->name, device_provider_override_get, env};
+    return device_provider_override_get(&from_env, info, err, err_len);
+}
+
+static int cache_get(const device_provider_t *p, device_info_t *info, char *err, size_t err_len) {
+    (void)p;
+    (void)err;
+    (void)err_len;
+    char path[512];
+    char boot_id[64];
+    device_info_cache_path(path, sizeof(path));
+    if (!path[0] || read_boot_id(boot_id, sizeof(boot_id)) != 0) return -1;
+    return cache_load(path, boot_id, info);
+}
+
+static int mtd_get(const device_provider_t *p, device_info_t *info, char *err, size_t err_len) {
+    (void)p;
+    const char *image = getenv("SRGN_MTD");
+    if (image && !image[0]) image = NULL;
+
+    char buf[DEVCFG_SIZE];
+    devcfg_t cfg;
+    device_info_t parsed;
+    if (read_devcfg(image, buf, sizeof(buf)) != 0) {
+        set_err(err, err_len, "cannot read devcfg", image ? image : DEVCFG_MTD);
+        return -1;
+    }
+    if (devcfg_parse(&cfg, buf, sizeof(buf)) != 0) return -1;
+    const int r = devcfg_device_info(&cfg, &parsed, err, err_len);
+    devcfg_free(&cfg);
+    if (r != 0) return -1;
+    *info = parsed;
+
+    /* an image is not this boot's device; don't let it answer for it later */
+    char path[512];
+    char boot_id[64];
+    device_info_cache_path(path, sizeof(path));
+    if (!image && path[0] && read_boot_id(boot_id, sizeof(boot_id)) == 0) cache_store(path, boot_id, info);
+    return 0;
+}
+
+const device_provider_t DEVICE_PROVIDER_ENV = {"env", env_get, NULL};
+const device_provider_t DEVICE_PROVIDER_CACHE = {"cache", cache_get, NULL};
+const device_provider_t DEVICE_PROVIDER_MTD = {"mtd", mtd_get, NULL};
+
+int device_info_probe(const device_provider_t *const *providers,
+                      size_t count,
+                      device_info_t *info,
+                      const char **source,
+                      char *err,
+                      size_t err_len) {
+    if (!providers || !info) return -1;
+    if (err && err_len) err[0] = 0;
+    for (size_t i = 0; i < count; i++) {
+        char why[128] = "";
+        device_info_t got;
+        if (providers[i]->get(providers[i], &got, why, sizeof(why)) == 0) {
+            *info = got;
+            if (source) *source = providers[i]->name;
+            return 0;
+        }
+        /* a provider that was asked for but failed (bad $SRGN_DEVICE) matters more than "no flash" */
+        if (why[0] && err && err_len && !err[0]) snprintf(err, err_len, "%s: %s", providers[i]->name, why);
+    }
+    return -1;
+}
+
+int get_device_info(device_info_t *info) {
+    const device_provider_t *const chain[] = {&DEVICE_PROVIDER_ENV, &DEVICE_PROVIDER_CACHE, &DEVICE_PROVIDER_MTD};
+    return device_info_probe(chain, sizeof(chain) / sizeof(chain[0]), info, NULL, NULL, 0);
+}
+
+void device_info_invalidate(void) {
+    char path[512];
+    device_info_cache_path(path, sizeof(path));
+    if (path[0]) (void)unlink(path);
+}
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <stddef.h>
+
 #define DEVCFG_OFFSET 0xFA000
+#define DEVCFG_SIZE   1024
+#define DEVCFG_MTD    "/dev/mtd0"      /* char device: pread, no block cache */
+#define DEVCFG_MTDBLOCK "/dev/mtdblock0" /* fallback when mtdchar is not built */
 
 typedef enum {
     DEVICE_REV_EPASS_0_2 = 0,
@@ -23,4 +28,51 @@ typedef struct {
 char* get_device_rev_str(device_rev_t rev);
 char* get_device_screen_str(device_screen_t screen);
 
-int get_device_info(device_info_t *info);
\ No newline at end of file
+/* Parse a revision string as written in devcfg ("0.2" .. "0.6"); 0 on success */
+int device_rev_from_str(const char *s, device_rev_t *out);
+
+/* "REV" or "REV:SCREEN" as written in devcfg ("0.5", "0.6:boe"); screen defaults to hsd */
+int device_info_from_str(const char *s, device_info_t *info);
+
+/*
+ * Device identity providers. device_info_probe asks each in turn and takes
+ * the first that answers, so the tool also runs where there is no flash
+ * (CI, containers, build hosts) when the identity is given some other way.
+ * get() returns 0 and fills info, or -1 (err set when the provider had
+ * something to say beyond "not available").
+ */
+typedef struct device_provider {
+    const char *name;
+    int (*get)(const struct device_provider *p, device_info_t *info, char *err, size_t err_len);
+    const char *arg;    /* provider-specific (the override string) */
+} device_provider_t;
+
+/* Command-line override: {"override", device_provider_override_get, "REV[:SCREEN]"} */
+int device_provider_override_get(const device_provider_t *p, device_info_t *info, char *err, size_t err_len);
+
+/* $SRGN_DEVICE in the same format */
+extern const device_provider_t DEVICE_PROVIDER_ENV;
+/* Result of an earlier flash read during this boot, kept under $SRGN_CACHE_DIR
+ * (default /run/srgn_config) and keyed by the kernel boot_id */
+extern const device_provider_t DEVICE_PROVIDER_CACHE;
+/* devcfg read from flash ($SRGN_MTD may name an image file instead); a
+ * successful read from the real device refreshes the cache */
+extern const device_provider_t DEVICE_PROVIDER_MTD;
+
+/* First provider that succeeds. *source (optional) gets its name. On failure
+ * err holds the first provider error, if any. 0 on success. */
+int device_info_probe(const device_provider_t *const *providers,
+                      size_t count,
+                      device_info_t *info,
+                      const char **source,
+                      char *err,
+                      size_t err_len);
+
+/* Default chain: env, cache, mtd. 0 on success. */
+int get_device_info(device_info_t *info);
+
+/* Path of the identity cache, or "" when caching is disabled */
+void device_info_cache_path(char *buf, size_t len);
+
+/* Forget the cached identity, e.g. after devcfg was rewritten */
+void device_info_invalidate(void);
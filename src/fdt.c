@@ -0,0 +1,98 @@
+#include "fdt.h"
+
+#include <string.h>
+
+#define FDT_BEGIN_NODE 1u
+#define FDT_END_NODE   2u
+#define FDT_PROP       3u
+#define FDT_NOP        4u
+#define FDT_END        9u
+
+#define FDT_HEADER_SIZE    40u
+#define FDT_FIRST_VERSION 16u /* oldest layout with size_dt_struct */
+
+static uint32_t be32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint32_t align4(uint32_t v) {
+    return (v + 3u) & ~3u;
+}
+
+int fdt_walk(const void *blob, size_t len, const fdt_visitor_t *v, void *ctx) {
+    const unsigned char *b = blob;
+    if (!b || len < FDT_HEADER_SIZE || be32(b) != FDT_MAGIC) return -1;
+
+    const uint32_t total = be32(b + 4);
+    const uint32_t off_struct = be32(b + 8);
+    const uint32_t off_strings = be32(b + 12);
+    const uint32_t version = be32(b + 20);
+    const uint32_t size_strings = be32(b + 32);
+    const uint32_t size_struct = be32(b + 36);
+    if (total > len || version < FDT_FIRST_VERSION) return -1;
+    if (off_struct % 4 || (uint64_t)off_struct + size_struct > total) return -1;
+    if ((uint64_t)off_strings + size_strings > total) return -1;
+
+    const unsigned char *s = b + off_struct;
+    const char *strings = (const char *)(b + off_strings);
+    uint32_t pos = 0;
+    int depth = -1;
+
+    while (pos + 4 <= size_struct) {
+        const uint32_t tok = be32(s + pos);
+        pos += 4;
+        switch (tok) {
+            case FDT_BEGIN_NODE: {
+                const char *name = (const char *)(s + pos);
+                const void *nul = memchr(name, 0, size_struct - pos);
+                if (!nul) return -1;
+                pos = align4(pos + (uint32_t)((const char *)nul - name) + 1);
+                depth++;
+                if (v && v->begin_node) {
+                    const int r = v->begin_node(ctx, name, depth);
+                    if (r) return r;
+                }
+                break;
+            }
+            case FDT_END_NODE:
+                if (depth < 0) return -1;
+                if (v && v->end_node) {
+                    const int r = v->end_node(ctx, depth);
+                    if (r) return r;
+                }
+                depth--;
+                break;
+            case FDT_PROP: {
+                if (pos + 8 > size_struct || depth < 0) return -1;
+                const uint32_t plen = be32(s + pos);
+                const uint32_t nameoff = be32(s + pos + 4);
+                pos += 8;
+                if (plen > size_struct - pos || nameoff >= size_strings) return -1;
+                const char *pname = strings + nameoff;
+                if (!memchr(pname, 0, size_strings - nameoff)) return -1;
+                if (v && v->prop) {
+                    const int r = v->prop(ctx, pname, s + pos, plen, depth);
+                    if (r) return r;
+                }
+                pos = align4(pos + plen);
+                break;
+            }
+            case FDT_NOP:
+                break;
+            case FDT_END:
+                return depth == -1 ? 0 : -1;
+            default:
+                return -1;
+        }
+    }
+    return -1; /* ran off the end without FDT_END */
+}
+
+const char *fdt_stringlist_next(const void *data, uint32_t len, uint32_t *pos) {
+    if (!data || !pos || *pos >= len) return NULL;
+    const char *str = (const char *)data + *pos;
+    const void *nul = memchr(str, 0, len - *pos);
+    if (!nul) return NULL;
+    *pos += (uint32_t)((const char *)nul - str) + 1;
+    return str;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Minimal flattened device tree (.dtb / .dtbo) reader: header checks and a
+ * bounds-checked walk over the structure block. No libfdt; just enough to
+ * read pinctrl groups out of the blobs U-Boot applies.
+ */
+
+#define FDT_MAGIC 0xd00dfeedu
+
+typedef struct {
+    /* any callback may be NULL; a non-zero return stops the walk and is returned by fdt_walk */
+    int (*begin_node)(void *ctx, const char *name, int depth);
+    int (*end_node)(void *ctx, int depth);
+    int (*prop)(void *ctx, const char *name, const void *data, uint32_t len, int depth);
+} fdt_visitor_t;
+
+/* Walk the structure block in order. The root node has depth 0, and a
+ * property has the depth of its node. Returns 0, -1 if the blob is malformed,
+ * or the first non-zero callback result. */
+int fdt_walk(const void *blob, size_t len, const fdt_visitor_t *v, void *ctx);
+
+/* Iterate a string-list property ("PA2", "PA3"): returns the next string at
+ * *pos and advances pos, or NULL at the end / on an unterminated entry. */
+const char *fdt_stringlist_next(const void *data, uint32_t len, uint32_t *pos);
@@ -0,0 +1,299 @@
+#include "filter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_profile.h"
+#include "config_registry.h"
+#include "config_solver.h"
+#include "overlay_pins.h"
+#include "uenv.h"
+
+int filter_confirm_force(const char *title, const char *prompt) {
+    (void)title;
+    (void)prompt;
+    return 0;
+}
+
+/* The per-item "Confirm" prompt is accepted; conflict and cascade prompts are rejected. */
+int filter_confirm_strict(const char *title, const char *prompt) {
+    (void)prompt;
+    if (!title) return 0;
+    return (strcmp(title, "Conflict") == 0 || strcmp(title, "Dependents") == 0) ? 1 : 0;
+}
+
+/* --force in filter mode: resolve conflicts but say so on stderr */
+static int filter_confirm_force_log(const char *title, const char *prompt) {
+    if (title && (strcmp(title, "Conflict") == 0 || strcmp(title, "Dependents") == 0)) {
+        /* prompts are laid out for the TUI; print them on one line */
+        fputs("srgn_config: ", stderr);
+        for (const char *p = prompt ? prompt : ""; *p; p++) {
+            if (*p == '\n') {
+                if (p[1] != ' ') fputc(' ', stderr);
+            } else {
+                fputc(*p, stderr);
+            }
+        }
+        fputc('\n', stderr);
+    }
+    return 0;
+}
+
+static void filter_usage(void) {
+    fprintf(stderr,
+            "usage: srgn_config --filter --rev <0.2|0.3|0.4|0.5|0.6> [--profile NAME|CODE] [--target ID,ID...]\n"
+            "                   [--enable ID]... [--disable ID]... [--force] [--save-profile NAME] < in > out\n");
+}
+
+int filter_parse_opt(filter_opts_t *o, int argc, char **argv, int *i) {
+    const char *a = argv[*i];
+    if (strcmp(a, "--force") == 0) {
+        o->force = true;
+        return 1;
+    }
+    if (strcmp(a, "--rev") == 0 && (*i + 1) < argc) {
+        *i += 1;
+        if (device_rev_from_str(argv[*i], &o->rev) != 0) {
+            fprintf(stderr, "srgn_config: unknown revision '%s'\n", argv[*i]);
+            return -1;
+        }
+        o->have_rev = true;
+        return 1;
+    }
+    if (strcmp(a, "--profile") == 0 && (*i + 1) < argc) {
+        *i += 1;
+        o->profile = argv[*i];
+        return 1;
+    }
+    if (strcmp(a, "--target") == 0 && (*i + 1) < argc) {
+        *i += 1;
+        o->target = argv[*i];
+        return 1;
+    }
+    if ((strcmp(a, "--enable") == 0 || strcmp(a, "--disable") == 0) && (*i + 1) < argc) {
+        o->ops[o->op_count].enable = (strcmp(a, "--enable") == 0);
+        o->ops[o->op_count].id = argv[*i + 1];
+        o->op_count++;
+        *i += 1;
+        return 1;
+    }
+    return 0;
+}
+
+int filter_default_rev(filter_opts_t *o) {
+    if (o->have_rev) return 0;
+    const device_provider_t *const env[] = {&DEVICE_PROVIDER_ENV};
+    device_info_t info;
+    char err[128];
+    if (device_info_probe(env, 1, &info, NULL, err, sizeof(err)) != 0) {
+        if (err[0]) fprintf(stderr, "srgn_config: %s\n", err);
+        return -1;
+    }
+    o->rev = info.rev;
+    o->have_rev = true;
+    return 0;
+}
+
+int filter_apply_ops(cfg_state_t *st,
+                     const filter_opts_t *o,
+                     int (*confirm)(const char *title, const char *prompt),
+                     bool *changed,
+                     char *err,
+                     size_t err_len) {
+    if (changed) *changed = false;
+
+    if (o->profile || o->profile_resolved) {
+        cfg_profile_t own;
+        const cfg_profile_t *p = o->profile_resolved;
+        if (!p) {
+            if (cfg_profile_resolve(o->profile, &own, err, err_len) != 0) return -1;
+            p = &own;
+        }
+        const cfg_bits_t before = st->enabled;
+        const uint32_t unknown_before = st->unknown_interface.count + st->unknown_ext.count;
+        const int r = cfg_profile_apply(st, p, o->rev, o->force, NULL, err, err_len);
+        if (p == &own) cfg_profile_free(&own);
+        if (r != 0) return r;
+        if (changed && (!cfg_bits_equal(&before, &st->enabled) ||
+                        unknown_before != st->unknown_interface.count + st->unknown_ext.count)) {
+            *changed = true;
+        }
+    }
+
+    if (o->target) {
+        cfg_bits_t wish = {{0}};
+        char id[128];
+        for (const char *p = o->target; *p;) {
+            const char *comma = strchr(p, ',');
+            const size_t n = comma ? (size_t)(comma - p) : strlen(p);
+            if (n > 0) {
+                snprintf(id, sizeof(id), "%.*s", (int)n, p);
+                const int idx = cfg_registry_find(st->reg, id);
+                if (idx < 0) {
+                    snprintf(err, err_len, "unknown item '%s'", id);
+                    return -1;
+                }
+                cfg_bits_set(&wish, (size_t)idx);
+            }
+            p += n + (comma ? 1 : 0);
+        }
+
+        cfg_solution_t sol;
+        if (cfg_solve(st->reg, o->rev, &wish, &sol) < 0) {
+            snprintf(err, err_len, "solver failed");
+            return -1;
+        }
+        if (cfg_bits_any(&sol.denied) && !o->force) {
+            char why[512];
+            cfg_solve_explain(st->reg, o->rev, &sol, why, sizeof(why));
+            /* one line per denied wish; keep them on one line for the caller */
+            for (char *q = why; *q; q++) {
+                if (*q == '\n') *q = q[1] ? ';' : 0;
+            }
+            snprintf(err, err_len, "target not satisfiable (use --force for best effort): %s", why);
+            return -4;
+        }
+        if (changed && !cfg_bits_equal(&st->enabled, &sol.enabled)) *changed = true;
+        st->enabled = sol.enabled;
+    }
+
+    for (size_t i = 0; i < o->op_count; i++) {
+        const filter_op_t *op = &o->ops[i];
+        const int idx = cfg_registry_find(st->reg, op->id);
+        if (idx < 0) {
+            snprintf(err, err_len, "unknown item '%s'", op->id);
+            return -1;
+        }
+        /* toggle only when the item is not already in the requested state */
+        if (cfg_state_is_enabled(st, (size_t)idx) == op->enable) continue;
+
+        const int r = cfg_state_toggle(st, (size_t)idx, o->rev, confirm);
+        if (r == -2) {
+            snprintf(err, err_len, "%s is unavailable on %s", op->id, get_device_rev_str(o->rev));
+            return r;
+        } else if ((r == -4 || r == -3) && op->enable) {
+            snprintf(err, err_len, "enabling %s conflicts with enabled items (use --force)", op->id);
+            return r;
+        } else if (r == -4 || r == -3) {
+            snprintf(err, err_len, "enabled items require %s (use --force to disable them too)", op->id);
+            return r;
+        } else if (r != 0) {
+            snprintf(err, err_len, "failed to toggle %s", op->id);
+            return r;
+        }
+        if (changed) *changed = true;
+    }
+    return 0;
+}
+
+int filter_requested(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0) return 1;
+    }
+    return 0;
+}
+
+int filter_run(int argc, char **argv) {
+    filter_opts_t o = {0};
+    const char *save_profile = NULL;
+    int ret = 0;
+
+    o.ops = calloc((size_t)argc, sizeof(filter_op_t));
+    if (!o.ops) return 2;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0) continue;
+        if (strcmp(argv[i], "--save-profile") == 0 && i + 1 < argc) {
+            save_profile = argv[++i];
+            if (!cfg_profile_name_ok(save_profile)) {
+                fprintf(stderr, "srgn_config: invalid profile name '%s' (letters, digits, '_' and '-')\n", save_profile);
+                free(o.ops);
+                return 1;
+            }
+            continue;
+        }
+        const int r = filter_parse_opt(&o, argc, argv, &i);
+        if (r < 0) {
+            free(o.ops);
+            return 1;
+        }
+        if (r == 0) {
+            filter_usage();
+            free(o.ops);
+            return 1;
+        }
+    }
+    if (filter_default_rev(&o) != 0) {
+        filter_usage();
+        free(o.ops);
+        return 1;
+    }
+
+    char err[256];
+    uenv_file_t u;
+    if (uenv_load_fp(stdin, &u, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: %s\n", err);
+        free(o.ops);
+        return 2;
+    }
+
+    /* stdin has no directory: the overlays are $SRGN_OVERLAY_DIR or ./overlays */
+    overlay_view_t view;
+    cfg_state_t st;
+    if (overlay_view_open(&view, NULL, o.rev) != 0 ||
+        cfg_state_init_from_uenv(&st, overlay_view_registry(&view), &u, o.rev) != 0) {
+        fprintf(stderr, "srgn_config: failed to initialize config state\n");
+        overlay_view_free(&view);
+        uenv_free(&u);
+        free(o.ops);
+        return 2;
+    }
+
+    if (filter_apply_ops(&st, &o, o.force ? filter_confirm_force_log : filter_confirm_strict,
+                         NULL, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: %s\n", err);
+        ret = 3;
+    }
+
+    if (ret == 0 && cfg_state_validate(&st, o.rev, err, sizeof(err)) != 0) {
+        fprintf(stderr, "srgn_config: invalid configuration: %s\n", err);
+        ret = 3;
+    }
+
+    if (ret == 0 && save_profile) {
+        cfg_profile_t p;
+        char code[1024];
+        if (cfg_profile_from_state(&p, save_profile, &st, o.rev) != 0) {
+            fprintf(stderr, "srgn_config: failed to build profile %s\n", save_profile);
+            ret = 4;
+        } else {
+            if (cfg_profile_save(&p, err, sizeof(err)) != 0) {
+                fprintf(stderr, "srgn_config: %s\n", err);
+                ret = 4;
+            } else if (cfg_profile_export(&p, code, sizeof(code)) < sizeof(code)) {
+                fprintf(stderr, "srgn_config: saved profile %s: %s\n", save_profile, code);
+            } else {
+                fprintf(stderr, "srgn_config: saved profile %s (too large to print as a code)\n", save_profile);
+            }
+            cfg_profile_free(&p);
+        }
+    }
+
+    if (ret == 0) {
+        cfg_lines_t lines = {0};
+        if (cfg_state_render(&st, &lines) != 0 ||
+            uenv_write_fp(stdout, &u, lines.interface_line, lines.ext_line) != 0 ||
+            fflush(stdout) != 0) {
+            fprintf(stderr, "srgn_config: failed to write output\n");
+            ret = 4;
+        }
+        cfg_lines_free(&lines);
+    }
+
+    cfg_state_free(&st);
+    overlay_view_free(&view);
+    uenv_free(&u);
+    free(o.ops);
+    return ret;
+}
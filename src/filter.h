@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "config_profile.h"
+#include "config_state.h"
+#include "device.h"
+
+/*
+ * Streaming uEnv transform:
+ *   srgn_config --filter --rev <0.2..0.6> [--profile NAME|CODE] [--target ID,ID...]
+ *               [--enable ID]... [--disable ID]... [--force] [--save-profile NAME]
+ *
+ * Reads uEnv from stdin, applies the operations in command-line order through
+ * cfg_state_toggle (same registry / conflict rules as the TUI) and writes the
+ * result to stdout. No terminal and no device probe; the only filesystem
+ * access is the profile directory (cfg_profile_dir), read by a stored
+ * --profile and written by --save-profile, and the overlay directory
+ * ($SRGN_OVERLAY_DIR, else ./overlays) and its cache, whose pins the registry takes
+ * (overlay_view_t).
+ *
+ * --target replaces the known items with the solver's best valid
+ * configuration for that wish list (unknown tokens are kept). Without
+ * --force, a wish that cannot be granted is an error. --profile does the
+ * same for a stored or exported profile (see config_profile.h) and adds its
+ * unknown tokens; it is applied before --target and the ops.
+ * --save-profile stores the result and prints its code on stderr.
+ * --rev may be left out when $SRGN_DEVICE gives the revision.
+ */
+
+typedef struct {
+    bool enable;
+    const char *id;
+} filter_op_t;
+
+/* Options shared by the non-interactive modes (--filter, --batch) */
+typedef struct {
+    filter_op_t *ops;   /* caller-owned, at least argc entries */
+    size_t op_count;
+    device_rev_t rev;
+    bool have_rev;
+    bool force;         /* auto-disable conflicting items / accept a partial --target */
+    const char *target; /* --target: comma-separated item list solved as a whole, or NULL */
+    const char *profile; /* --profile: stored profile name or exported code, or NULL */
+    const cfg_profile_t *profile_resolved; /* profile decoded once by the caller (--batch), or NULL */
+} filter_opts_t;
+
+/* Try to consume argv[*i] (and its value) as a shared option.
+ * Returns 1 if consumed, 0 if not a shared option, -1 on a bad value. */
+int filter_parse_opt(filter_opts_t *o, int argc, char **argv, int *i);
+
+/* Without --rev, take the revision from $SRGN_DEVICE (never from flash).
+ * Returns 0 if o has a revision afterwards. */
+int filter_default_rev(filter_opts_t *o);
+
+/* Apply --profile (profile_resolved if set, otherwise resolved here), then --target
+ * through the solver, then ops in order. *changed is set if any item was toggled.
+ * Returns 0 on success; on failure err describes the rejected op. */
+int filter_apply_ops(cfg_state_t *st,
+                     const filter_opts_t *o,
+                     int (*confirm)(const char *title, const char *prompt),
+                     bool *changed,
+                     char *err,
+                     size_t err_len);
+
+/* confirm callbacks for filter_apply_ops: accept everything / reject conflicts */
+int filter_confirm_force(const char *title, const char *prompt);
+int filter_confirm_strict(const char *title, const char *prompt);
+
+/* Returns true if argv requests filter mode */
+int filter_requested(int argc, char **argv);
+
+/* Exit code: 0 ok, 1 usage, 2 bad input, 3 operation rejected, 4 write failed */
+int filter_run(int argc, char **argv);
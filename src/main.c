@@ -19,7 +19,12 @@
 #include "ad_priv.h"
 #include "anbui.h"
 
+#include "batch.h"
+#include "cli.h"
+#include "devcfg_tool.h"
 #include "device.h"
+#include "filter.h"
+#include "startup.h"
 #include "ui.h"
 
 extern ad_ConsoleConfig ad_s_con;
@@ -37,27 +42,66 @@ static const char *get_uenv_path_from_args_or_env(int argc, char **argv) {
     return path;
 }
 
+static const char *get_device_override(int argc, char **argv) {
+    const char *spec = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--device") == 0 && (i + 1) < argc) {
+            spec = argv[++i];
+        }
+    }
+    return spec;
+}
+
 int main(int argc, char *argv[]) {
+    if (cli_requested(argc, argv)) {
+        return cli_run(argc, argv);
+    }
+    if (filter_requested(argc, argv)) {
+        return filter_run(argc, argv);
+    }
+    if (batch_requested(argc, argv)) {
+        return batch_run(argc, argv);
+    }
+    if (devcfg_requested(argc, argv)) {
+        return devcfg_run(argc, argv);
+    }
+
+    const char *uenv_path = get_uenv_path_from_args_or_env(argc, argv);
+    const device_provider_t override = {"override", device_provider_override_get, get_device_override(argc, argv)};
+    const device_provider_t *const providers[] = {&override, &DEVICE_PROVIDER_ENV, &DEVICE_PROVIDER_CACHE,
+                                                  &DEVICE_PROVIDER_MTD};
+
+    /* probe the device and load uEnv while the terminal is being set up */
+    startup_t boot;
+    startup_begin(&boot, providers, sizeof(providers) / sizeof(providers[0]), uenv_path);
+
+    startup_phase_begin(STARTUP_TERMINAL);
     ad_init("Shirogane EPass Device Config Tool V0.1");
     // fix srgnvs8pix
-    if (strcmp(ttyname(fileno(stdin)), "/dev/tty0") == 0) {
+    const char *tty = ttyname(fileno(stdin));
+    if (tty && strcmp(tty, "/dev/tty0") == 0) {
         printf("current tty is /dev/tty0\n");
         ad_s_con.width -= 3;
     }
+    startup_phase_end(STARTUP_TERMINAL);
 
-    char dev_status_buf[512];
-    device_info_t dev_info;
-    if (get_device_info(&dev_info) != 0) {
-        printf("get device info failed\n");
+    startup_join(&boot);
+    if (boot.device_status != 0) {
+        ad_deinit();
+        ui_preload_free(&boot.pre);
+        printf("get device info failed%s%s\n", boot.dev_err[0] ? ": " : "", boot.dev_err);
+        printf("(use --device REV[:SCREEN] or SRGN_DEVICE without flash)\n");
         return -1;
     }
+
+    char dev_status_buf[512];
     snprintf(dev_status_buf, sizeof(dev_status_buf), "Dev:%s\nScreen:%s",
-           get_device_rev_str(dev_info.rev),
-           get_device_screen_str(dev_info.screen));
+           get_device_rev_str(boot.dev.rev),
+           get_device_screen_str(boot.dev.screen));
     puts(dev_status_buf);
 
-    const char *uenv_path = get_uenv_path_from_args_or_env(argc, argv);
-    (void)ui_run(&dev_info, uenv_path);
+    ad_setMenuReadyHook(startup_first_frame);
+    (void)ui_run(&boot.dev, uenv_path, &boot.pre);
 
     ad_deinit();
 
@@ -0,0 +1,160 @@
+#include "mtd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <mtd/mtd-user.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void set_err(char *err, size_t err_len, const char *fmt, ...) {
+    if (!err || !err_len) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(err, err_len, fmt, ap);
+    va_end(ap);
+}
+
+int mtd_open(mtd_dev_t *m, const char *path, bool writable, char *err, size_t err_len) {
+    if (!m || !path) return -1;
+    memset(m, 0, sizeof(*m));
+    m->fd = open(path, (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (m->fd < 0) {
+        set_err(err, err_len, "cannot open %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat sb;
+    struct mtd_info_user info;
+    if (fstat(m->fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+        const char *env = getenv("SRGN_MTD_ERASESIZE");
+        const unsigned long es = env ? strtoul(env, NULL, 0) : MTD_FILE_ERASESIZE;
+        m->is_file = true;
+        m->erasesize = (uint32_t)es;
+        m->size = (uint64_t)sb.st_size;
+        if (es == 0 || (es & (es - 1)) != 0) {
+            set_err(err, err_len, "SRGN_MTD_ERASESIZE must be a power of two");
+            mtd_close(m);
+            return -1;
+        }
+    } else if (ioctl(m->fd, MEMGETINFO, &info) == 0) {
+        m->erasesize = info.erasesize;
+        m->size = info.size;
+    } else {
+        set_err(err, err_len, "%s is not an mtd device: %s", path, strerror(errno));
+        mtd_close(m);
+        return -1;
+    }
+    return 0;
+}
+
+void mtd_close(mtd_dev_t *m) {
+    if (!m) return;
+    if (m->fd >= 0) close(m->fd);
+    m->fd = -1;
+}
+
+int mtd_read(const mtd_dev_t *m, uint64_t off, void *buf, size_t len) {
+    if (!m || off > m->size || len > m->size - off) return -1;
+    size_t got = 0;
+    while (got < len) {
+        const ssize_t n = pread(m->fd, (char *)buf + got, len - got, (off_t)(off + got));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        got += (size_t)n;
+    }
+    return 0;
+}
+
+static int write_all(const mtd_dev_t *m, uint64_t off, const void *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        const ssize_t n = pwrite(m->fd, (const char *)buf + done, len - done, (off_t)(off + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int erase_block(const mtd_dev_t *m, uint64_t off, uint8_t *scratch) {
+    if (m->is_file) {
+        memset(scratch, 0xFF, m->erasesize);
+        return write_all(m, off, scratch, m->erasesize);
+    }
+    struct erase_info_user ei = {.start = (uint32_t)off, .length = m->erasesize};
+    return ioctl(m->fd, MEMERASE, &ei);
+}
+
+/* NOR programming can only clear bits */
+static bool needs_erase(const uint8_t *old, const uint8_t *new, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if ((old[i] & new[i]) != new[i]) return true;
+    }
+    return false;
+}
+
+int mtd_update(const mtd_dev_t *m,
+               uint64_t off,
+               const void *data,
+               size_t len,
+               mtd_update_stats_t *stats,
+               char *err,
+               size_t err_len) {
+    if (stats) memset(stats, 0, sizeof(*stats));
+    if (!m || !data || off > m->size || len > m->size - off || m->erasesize == 0) {
+        set_err(err, err_len, "range is outside the device");
+        return -1;
+    }
+    const uint32_t es = m->erasesize;
+    uint8_t *old = malloc(es);
+    uint8_t *new = malloc(es);
+    uint8_t *check = malloc(es);
+    int ret = -1;
+    if (!old || !new || !check) {
+        set_err(err, err_len, "out of memory");
+        goto out;
+    }
+
+    for (uint64_t block = off - off % es; block < off + len; block += es) {
+        if (mtd_read(m, block, old, es) != 0) {
+            set_err(err, err_len, "read failed at 0x%llx", (unsigned long long)block);
+            goto out;
+        }
+        /* overlay the part of data that falls into this block */
+        memcpy(new, old, es);
+        const uint64_t from = block > off ? block : off;
+        const uint64_t to = (block + es < off + len) ? block + es : off + len;
+        memcpy(new + (from - block), (const uint8_t *)data + (from - off), (size_t)(to - from));
+        if (memcmp(old, new, es) == 0) continue;
+
+        if (stats) stats->blocks_changed++;
+        if (needs_erase(old, new, es)) {
+            if (erase_block(m, block, check) != 0) {
+                set_err(err, err_len, "erase failed at 0x%llx: %s", (unsigned long long)block, strerror(errno));
+                goto out;
+            }
+            if (stats) stats->blocks_erased++;
+        }
+        if (write_all(m, block, new, es) != 0) {
+            set_err(err, err_len, "write failed at 0x%llx: %s", (unsigned long long)block, strerror(errno));
+            goto out;
+        }
+        if (mtd_read(m, block, check, es) != 0 || memcmp(check, new, es) != 0) {
+            set_err(err, err_len, "verify failed at 0x%llx", (unsigned long long)block);
+            goto out;
+        }
+    }
+    if (!m->is_file) (void)fsync(m->fd);
+    ret = 0;
+
+out:
+    free(old);
+    free(new);
+    free(check);
+    return ret;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Raw flash access through the mtd char device. A regular file can stand
+ * in for the device (tests, image editing): it is read and written the same
+ * way, and erasing fills the block with 0xFF.
+ */
+
+typedef struct {
+    int fd;
+    bool is_file;       /* stand-in, no ioctls */
+    uint32_t erasesize;
+    uint64_t size;
+} mtd_dev_t;
+
+/* Erase block size assumed for a file stand-in ($SRGN_MTD_ERASESIZE overrides) */
+#define MTD_FILE_ERASESIZE 4096
+
+int  mtd_open(mtd_dev_t *m, const char *path, bool writable, char *err, size_t err_len);
+void mtd_close(mtd_dev_t *m);
+
+int mtd_read(const mtd_dev_t *m, uint64_t off, void *buf, size_t len);
+
+typedef struct {
+    unsigned blocks_changed; /* erase blocks that differed */
+    unsigned blocks_erased;  /* ... of which needed an erase (a write can only clear bits) */
+} mtd_update_stats_t;
+
+/* Make [off, off+len) hold data, touching only the erase blocks that differ:
+ * read-modify-(erase-)write of each block, then read back and compare.
+ * Returns 0, or -1 with err set (a failed verify included). */
+int mtd_update(const mtd_dev_t *m,
+               uint64_t off,
+               const void *data,
+               size_t len,
+               mtd_update_stats_t *stats,
+               char *err,
+               size_t err_len);
@@ -0,0 +1,284 @@
+#define _GNU_SOURCE
+#include "overlay_pins.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fdt.h"
+
+#define PINS_CACHE_MAGIC  "srgn-pins 2"
+#define OVERLAY_MAX_BYTES (1u << 20) /* overlays are a few KB; anything bigger isn't one */
+
+/* ---- blob parsing ---- */
+
+static int pins_prop(void *ctx, const char *name, const void *data, uint32_t len, int depth) {
+    overlay_pins_t *out = ctx;
+    (void)depth;
+    if (strcmp(name, "pins") == 0 || strcmp(name, "allwinner,pins") == 0) {
+        uint32_t pos = 0;
+        for (const char *pin; (pin = fdt_stringlist_next(data, len, &pos));) {
+            /* pins not on the header (PE4, ...) can't collide with another option */
+            out->pins |= cfg_pin_from_name(pin);
+        }
+        out->has_pins = true;
+    }
+    return 0;
+}
+
+int overlay_pins_parse(const void *blob, size_t len, overlay_pins_t *out) {
+    if (!out) return -1;
+    memset(out, 0, sizeof(*out));
+    const fdt_visitor_t v = {.prop = pins_prop};
+    return fdt_walk(blob, len, &v, out) == 0 ? 0 : -1;
+}
+
+static int parse_file(int dirfd, const char *file, const struct stat *sb, overlay_pins_t *out) {
+    if (sb->st_size <= 0 || sb->st_size > OVERLAY_MAX_BYTES) return -1;
+    const int fd = openat(dirfd, file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    const size_t size = (size_t)sb->st_size;
+    unsigned char *buf = malloc(size);
+    size_t got = 0;
+    while (buf && got < size) {
+        const ssize_t n = pread(fd, buf + got, size - got, (off_t)got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    const int r = (buf && got == size) ? overlay_pins_parse(buf, size, out) : -1;
+    free(buf);
+    return r;
+}
+
+/* ---- cache: one line per overlay, "name size mtime_sec mtime_nsec ok has_pins pins" ---- */
+
+typedef struct {
+    char name[64];
+    long long size;
+    long long sec;
+    long nsec;
+    bool ok;              /* parsed successfully */
+    overlay_pins_t pins;
+} pins_entry_t;
+
+typedef struct {
+    pins_entry_t *v;
+    size_t n;
+    size_t cap;
+} pins_cache_t;
+
+static pins_entry_t *cache_add(pins_cache_t *c) {
+    if (c->n == c->cap) {
+        const size_t cap = c->cap ? c->cap * 2 : 32;
+        pins_entry_t *nv = realloc(c->v, cap * sizeof(pins_entry_t));
+        if (!nv) return NULL;
+        c->v = nv;
+        c->cap = cap;
+    }
+    pins_entry_t *e = &c->v[c->n++];
+    memset(e, 0, sizeof(*e));
+    return e;
+}
+
+static void cache_load(pins_cache_t *c, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    char line[1024];
+    if (!fgets(line, sizeof(line), fp) || strcmp(line, PINS_CACHE_MAGIC "\n") != 0) {
+        fclose(fp);
+        return;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        pins_entry_t e;
+        memset(&e, 0, sizeof(e));
+        int ok = 0, has_pins = 0;
+        unsigned pins = 0;
+        if (sscanf(line, "%63s %lld %lld %ld %d %d %x", e.name, &e.size, &e.sec, &e.nsec, &ok, &has_pins, &pins) != 7) {
+            continue;
+        }
+        e.ok = ok != 0;
+        e.pins.has_pins = has_pins != 0;
+        e.pins.pins = (cfg_pins_t)pins;
+        pins_entry_t *slot = cache_add(c);
+        if (slot) *slot = e;
+    }
+    fclose(fp);
+}
+
+static void cache_store(const pins_cache_t *c, const char *path) {
+    char tmp[520];
+    FILE *fp = overlay_cache_create(path, tmp, sizeof(tmp));
+    if (!fp) return;
+    fputs(PINS_CACHE_MAGIC "\n", fp);
+    for (size_t i = 0; i < c->n; i++) {
+        const pins_entry_t *e = &c->v[i];
+        fprintf(fp, "%s %lld %lld %ld %d %d %x\n", e->name, e->size, e->sec, e->nsec, e->ok ? 1 : 0,
+                e->pins.has_pins ? 1 : 0, (unsigned)e->pins.pins);
+    }
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+static pins_entry_t *cache_find(pins_cache_t *c, const char *name) {
+    for (size_t i = 0; i < c->n; i++) {
+        if (strcmp(c->v[i].name, name) == 0) return &c->v[i];
+    }
+    return NULL;
+}
+
+/* Pins of every present overlay, from the cache or the blob */
+static int read_all(const overlay_index_t *ox, const cfg_registry_t *base, overlay_pins_t *pins, cfg_bits_t *have) {
+    char path[512];
+    const bool cached = overlay_cache_path(ox->dir, "pins", path, sizeof(path)) == 0;
+    pins_cache_t c = {0};
+    if (cached) cache_load(&c, path);
+
+    const int dirfd = open(ox->dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        free(c.v);
+        return -1;
+    }
+    bool dirty = false;
+    for (size_t i = cfg_bits_next(&ox->present, 0); i < base->count; i = cfg_bits_next(&ox->present, i + 1)) {
+        const char *id = base->items[i].id;
+        char file[96];
+        struct stat sb;
+        if (strlen(id) >= sizeof(((pins_entry_t *)0)->name)) continue;
+        snprintf(file, sizeof(file), "%s.dtbo", id);
+        if (fstatat(dirfd, file, &sb, 0) != 0) continue;
+
+        pins_entry_t *e = cache_find(&c, id);
+        if (!e || e->size != (long long)sb.st_size || e->sec != (long long)sb.st_mtim.tv_sec || e->nsec != sb.st_mtim.tv_nsec) {
+            if (!e && !(e = cache_add(&c))) continue;
+            snprintf(e->name, sizeof(e->name), "%s", id);
+            e->size = (long long)sb.st_size;
+            e->sec = (long long)sb.st_mtim.tv_sec;
+            e->nsec = sb.st_mtim.tv_nsec;
+            e->ok = parse_file(dirfd, file, &sb, &e->pins) == 0;
+            dirty = true;
+        }
+        if (e->ok) {
+            pins[i] = e->pins;
+            cfg_bits_set(have, i);
+        }
+    }
+    close(dirfd);
+    if (cached && dirty) cache_store(&c, path);
+    free(c.v);
+    return 0;
+}
+
+/* ---- derived registry ---- */
+
+int overlay_registry_derive(overlay_registry_t *out,
+                            const cfg_registry_t *base,
+                            const overlay_index_t *ox,
+                            int rank) {
+    if (!out || !base || !ox || !ox->valid || rank < 0 || rank >= CFG_REV_RANKS) return -1;
+    const size_t n = base->count;
+
+    overlay_pins_t *pins = calloc(n ? n : 1, sizeof(overlay_pins_t));
+    if (!pins) return -1;
+    cfg_bits_t have = {{0}};
+    if (read_all(ox, base, pins, &have) != 0 || !cfg_bits_any(&have)) {
+        free(pins);
+        return -1;
+    }
+
+    overlay_registry_t r;
+    memset(&r, 0, sizeof(r));
+    const uint32_t cap = cfg_registry_hash_capacity(n);
+    r.items = calloc(n ? n : 1, sizeof(cfg_item_t));
+    r.slots = malloc(cap * sizeof(uint16_t));
+    r.masks = calloc(CFG_MASK_STORAGE(n) + 1, sizeof(cfg_bits_t));
+    if (!r.items || !r.slots || !r.masks) goto fail;
+
+    for (size_t i = 0; i < n; i++) {
+        r.items[i] = base->items[i]; /* listed conflicts point into base, which outlives r */
+        /* overlays that borrow a pin group from the base tree name no pins; keep the table's */
+        if (cfg_bits_test(&have, i) && pins[i].has_pins) {
+            r.items[i].pins[rank] = pins[i].pins;
+            cfg_bits_set(&r.derived, i);
+        }
+    }
+    /* a device overlay may repeat its bus's pin group; those pins are the bus's, not a conflict */
+    for (size_t i = 0; i < n; i++) {
+        const cfg_bits_t *req = &base->requires_closure[i];
+        for (size_t j = cfg_bits_next(req, 0); j < n; j = cfg_bits_next(req, j + 1)) {
+            if (cfg_bits_test(&r.derived, i) || cfg_bits_test(&r.derived, j)) r.items[i].pins[rank] &= ~r.items[j].pins[rank];
+        }
+        if (cfg_bits_test(&r.derived, i) && r.items[i].pins[rank] != base->items[i].pins[rank]) {
+            cfg_bits_set(&r.differs, i);
+        }
+    }
+
+    r.reg.items = r.items;
+    r.reg.count = n;
+    if (cfg_registry_build_hash(&r.reg, r.slots, cap) != 0) {
+        r.reg.hash_slots = NULL;
+        r.reg.hash_size = 0;
+    }
+    if (cfg_registry_build_masks(&r.reg, r.masks) != 0) goto fail;
+
+    free(pins);
+    *out = r;
+    return 0;
+
+fail:
+    free(pins);
+    overlay_registry_free(&r);
+    return -1;
+}
+
+void overlay_registry_free(overlay_registry_t *r) {
+    if (!r) return;
+    free(r->items);
+    free(r->slots);
+    free(r->masks);
+    memset(r, 0, sizeof(*r));
+}
+
+/* ---- view ---- */
+
+int overlay_view_scan(overlay_view_t *v, const char *uenv_path) {
+    if (!v) return -1;
+    memset(v, 0, sizeof(*v));
+    v->rank = -1;
+    v->base = cfg_registry_get();
+    if (!v->base) return -1;
+    /* an unreadable directory leaves the index invalid, and the registry plain */
+    char dir[512];
+    (void)overlay_scan(&v->overlays, overlay_default_dir(uenv_path, dir, sizeof(dir)), v->base);
+    return 0;
+}
+
+int overlay_view_open(overlay_view_t *v, const char *uenv_path, device_rev_t rev) {
+    if (overlay_view_scan(v, uenv_path) != 0) return -1;
+    (void)overlay_view_refresh(v, rev);
+    return 0;
+}
+
+int overlay_view_refresh(overlay_view_t *v, device_rev_t rev) {
+    if (!v || !v->base) return 0;
+    const int rank = device_rev_rank(rev);
+    /* one stat(); the directory is only re-listed if its mtime moved */
+    if (!overlay_refresh(&v->overlays, v->base) && rank == v->rank) return 0;
+
+    v->rank = rank;
+    if (v->derived_valid) {
+        overlay_registry_free(&v->derived);
+        v->derived_valid = false;
+    }
+    v->derived_valid = overlay_registry_derive(&v->derived, v->base, &v->overlays, rank) == 0;
+    return 1;
+}
+
+void overlay_view_free(overlay_view_t *v) {
+    if (!v) return;
+    overlay_index_free(&v->overlays);
+    if (v->derived_valid) overlay_registry_free(&v->derived);
+    memset(v, 0, sizeof(*v));
+}
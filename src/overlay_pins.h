@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_registry.h"
+#include "overlay_scan.h"
+
+/*
+ * Pin usage read from the overlay blobs themselves, so conflicts follow the
+ * .dtbo files U-Boot applies instead of a hand-written table.
+ */
+
+typedef struct {
+    cfg_pins_t pins;       /* exposed pins named by pinctrl groups ("pins" / "allwinner,pins") */
+    bool has_pins;         /* the blob defines pin groups itself */
+} overlay_pins_t;
+
+/* Parse one .dtbo. Returns 0, or -1 if it is not a valid flattened device tree. */
+int overlay_pins_parse(const void *blob, size_t len, overlay_pins_t *out);
+
+typedef struct {
+    cfg_registry_t reg;
+    cfg_item_t *items;
+    uint16_t *slots;
+    cfg_bits_t *masks;
+
+    cfg_bits_t derived; /* items whose pins[rank] came from their overlay */
+    cfg_bits_t differs; /* ... and disagree with the base table */
+} overlay_registry_t;
+
+/*
+ * Copy of base where every item with a parseable overlay in ox takes
+ * pins[rank] from the blob; conflicts still come from pin overlap only.
+ * Overlays that merely modify the same node (a bus and the devices added
+ * under it) do not conflict, and an item never conflicts with the items it
+ * requires: pins it shares with them are theirs. Parse results are cached in the cache directory keyed by each file's size
+ * and mtime, so blobs are only read again when they change.
+ * Returns 0, or -1 (out untouched) if nothing could be derived.
+ */
+int overlay_registry_derive(overlay_registry_t *out,
+                            const cfg_registry_t *base,
+                            const overlay_index_t *ox,
+                            int rank);
+
+void overlay_registry_free(overlay_registry_t *r);
+
+/*
+ * Registry a uEnv file is checked against: cfg_registry_get() with pins
+ * derived from the overlays next to it (overlay_default_dir). The TUI, the
+ * subcommands, --filter / --batch and srgn_configd all go through this, so
+ * they accept the same configurations. Without usable overlays it is the
+ * plain registry. Item indices never differ from cfg_registry_get()'s.
+ */
+typedef struct {
+    const cfg_registry_t *base;
+    overlay_index_t overlays;
+    int rank;                   /* revision rank derived for; -1 until the first refresh */
+    overlay_registry_t derived;
+    bool derived_valid;
+} overlay_view_t;
+
+/* Scan the overlay directory of uenv_path (NULL: stdin, i.e. the current
+ * directory); no revision yet. -1 only if there is no registry at all. */
+int overlay_view_scan(overlay_view_t *v, const char *uenv_path);
+
+/* overlay_view_scan plus the first overlay_view_refresh */
+int overlay_view_open(overlay_view_t *v, const char *uenv_path, device_rev_t rev);
+
+/* Rescan if the directory changed and re-derive if it did or rev differs.
+ * Returns 1 if the registry was rebuilt: states built on the old one must
+ * be pointed at overlay_view_registry() again. */
+int overlay_view_refresh(overlay_view_t *v, device_rev_t rev);
+
+static inline const cfg_registry_t *overlay_view_registry(const overlay_view_t *v) {
+    return v->derived_valid ? &v->derived.reg : v->base;
+}
+
+void overlay_view_free(overlay_view_t *v);
@@ -0,0 +1,270 @@
+#define _GNU_SOURCE
+#include "overlay_scan.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define OVERLAY_SUFFIX     ".dtbo"
+#define OVERLAY_SUFFIX_LEN 5
+#define CACHE_MAGIC        "srgn-overlays 1"
+
+#ifndef SRGN_CACHE_DIR
+#define SRGN_CACHE_DIR "/run/srgn_config"
+#endif
+
+/* glibc only grew a getdents64() wrapper in 2.30 */
+struct overlay_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+const char *overlay_default_dir(const char *uenv_path, char *buf, size_t len) {
+    const char *env = getenv("SRGN_OVERLAY_DIR");
+    if (env && env[0]) return env;
+    const char *slash = uenv_path ? strrchr(uenv_path, '/') : NULL;
+    if (!slash) {
+        snprintf(buf, len, "overlays");
+    } else {
+        snprintf(buf, len, "%.*s/overlays", (int)(slash - uenv_path), uenv_path);
+    }
+    return buf;
+}
+
+static void free_names(overlay_index_t *ox) {
+    for (size_t i = 0; i < ox->count; i++) free(ox->names[i]);
+    free(ox->names);
+    free(ox->orphans);
+    ox->names = NULL;
+    ox->count = 0;
+    ox->orphans = NULL;
+    ox->orphan_count = 0;
+    memset(&ox->present, 0, sizeof(ox->present));
+}
+
+static int push_name(overlay_index_t *ox, size_t *cap, const char *name, size_t len) {
+    if (ox->count == *cap) {
+        const size_t ncap = *cap ? *cap * 2 : 32;
+        char **nv = realloc(ox->names, ncap * sizeof(char *));
+        if (!nv) return -1;
+        ox->names = nv;
+        *cap = ncap;
+    }
+    char *s = strndup(name, len);
+    if (!s) return -1;
+    ox->names[ox->count++] = s;
+    return 0;
+}
+
+/* ---- directory listing ---- */
+
+static int list_dir(int fd, overlay_index_t *ox) {
+    char buf[32768];
+    size_t cap = 0;
+    for (;;) {
+        const long n = syscall(SYS_getdents64, fd, buf, sizeof(buf));
+        if (n < 0) return -1;
+        if (n == 0) return 0;
+        for (long off = 0; off < n;) {
+            const struct overlay_dirent64 *d = (const struct overlay_dirent64 *)(buf + off);
+            off += d->d_reclen;
+
+            const size_t len = strlen(d->d_name);
+            if (d->d_name[0] == '.' || len <= OVERLAY_SUFFIX_LEN) continue;
+            if (memcmp(d->d_name + len - OVERLAY_SUFFIX_LEN, OVERLAY_SUFFIX, OVERLAY_SUFFIX_LEN) != 0) continue;
+            if (d->d_type != DT_REG) {
+                /* symlinks and filesystems without d_type: U-Boot needs a regular file behind it */
+                struct stat sb;
+                if (d->d_type != DT_LNK && d->d_type != DT_UNKNOWN) continue;
+                if (fstatat(fd, d->d_name, &sb, 0) != 0 || !S_ISREG(sb.st_mode)) continue;
+            }
+            if (push_name(ox, &cap, d->d_name, len - OVERLAY_SUFFIX_LEN) != 0) return -1;
+        }
+    }
+}
+
+/* ---- cache file ---- */
+
+int overlay_cache_path(const char *dir, const char *kind, char *buf, size_t len) {
+    const char *base = getenv("SRGN_CACHE_DIR");
+    if (!base) base = SRGN_CACHE_DIR;
+    if (!base[0]) return -1; /* caching disabled */
+    snprintf(buf, len, "%s/%s-%08x.cache", base, kind, (unsigned)cfg_hash_id(dir, 0));
+    return 0;
+}
+
+static int cache_load(overlay_index_t *ox) {
+    char path[512];
+    if (overlay_cache_path(ox->dir, "overlays", path, sizeof(path)) != 0) return -1;
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+
+    char *line = NULL;
+    size_t lcap = 0;
+    size_t cap = 0;
+    int ret = -1;
+    unsigned long long dev = 0, ino = 0;
+    long long sec = 0;
+    long nsec = 0;
+    ssize_t n;
+
+    if ((n = getline(&line, &lcap, fp)) < 0 || strncmp(line, CACHE_MAGIC "\n", (size_t)n) != 0) goto out;
+    if (getline(&line, &lcap, fp) < 0 || sscanf(line, "key %llu %llu %lld %ld", &dev, &ino, &sec, &nsec) != 4) goto out;
+    if ((dev_t)dev != ox->dev || (ino_t)ino != ox->ino || sec != (long long)ox->mtime.tv_sec || nsec != ox->mtime.tv_nsec) goto out;
+    if ((n = getline(&line, &lcap, fp)) < 4 || strncmp(line, "dir ", 4) != 0) goto out;
+    line[n - 1] = 0;
+    if (strcmp(line + 4, ox->dir) != 0) goto out;
+
+    while ((n = getline(&line, &lcap, fp)) > 0) {
+        if (line[n - 1] != '\n') goto out; /* torn write */
+        if (push_name(ox, &cap, line, (size_t)n - 1) != 0) goto out;
+    }
+    ret = 0;
+
+out:
+    if (ret != 0) free_names(ox);
+    free(line);
+    fclose(fp);
+    return ret;
+}
+
+FILE *overlay_cache_create(const char *path, char *tmp, size_t tmp_len) {
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        *slash = 0;
+        (void)mkdir(dir, 0755);
+    }
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+    return fopen(tmp, "w");
+}
+
+/* Best effort: a missing cache only costs a directory listing */
+static void cache_store(const overlay_index_t *ox) {
+    char path[512];
+    char tmp[520];
+    if (overlay_cache_path(ox->dir, "overlays", path, sizeof(path)) != 0) return;
+    FILE *fp = overlay_cache_create(path, tmp, sizeof(tmp));
+    if (!fp) return;
+    fprintf(fp, CACHE_MAGIC "\nkey %llu %llu %lld %ld\ndir %s\n", (unsigned long long)ox->dev,
+            (unsigned long long)ox->ino, (long long)ox->mtime.tv_sec, (long)ox->mtime.tv_nsec, ox->dir);
+    for (size_t i = 0; i < ox->count; i++) fprintf(fp, "%s\n", ox->names[i]);
+    if (fclose(fp) != 0 || rename(tmp, path) != 0) unlink(tmp);
+}
+
+/* ---- index ---- */
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int build_index(overlay_index_t *ox, const cfg_registry_t *reg) {
+    qsort(ox->names, ox->count, sizeof(char *), cmp_name);
+    ox->orphans = calloc(ox->count ? ox->count : 1, sizeof(size_t));
+    if (!ox->orphans) return -1;
+    for (size_t i = 0; i < ox->count; i++) {
+        const int idx = cfg_registry_find(reg, ox->names[i]);
+        if (idx >= 0) {
+            cfg_bits_set(&ox->present, (size_t)idx);
+        } else {
+            ox->orphans[ox->orphan_count++] = i;
+        }
+    }
+    return 0;
+}
+
+static bool same_key(const overlay_index_t *ox, const struct stat *sb) {
+    return ox->dev == sb->st_dev && ox->ino == sb->st_ino && ox->mtime.tv_sec == sb->st_mtim.tv_sec &&
+           ox->mtime.tv_nsec == sb->st_mtim.tv_nsec;
+}
+
+int overlay_scan(overlay_index_t *ox, const char *dir, const cfg_registry_t *reg) {
+    if (!ox || !dir || !reg) return -1;
+    char *d = strdup(dir);
+    overlay_index_free(ox);
+    ox->dir = d;
+    if (!d) return -1;
+
+    const int fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        close(fd);
+        return -1;
+    }
+    ox->dev = sb.st_dev;
+    ox->ino = sb.st_ino;
+    ox->mtime = sb.st_mtim;
+
+    int r = 0;
+    if (cache_load(ox) != 0) {
+        r = list_dir(fd, ox);
+        if (r == 0) cache_store(ox);
+    }
+    close(fd);
+    if (r != 0 || build_index(ox, reg) != 0) {
+        free_names(ox);
+        return -1;
+    }
+    ox->valid = true;
+    return 0;
+}
+
+int overlay_refresh(overlay_index_t *ox, const cfg_registry_t *reg) {
+    if (!ox || !ox->dir) return 0;
+    struct stat sb;
+    const bool readable = (stat(ox->dir, &sb) == 0 && S_ISDIR(sb.st_mode));
+    if (readable == ox->valid && (!readable || same_key(ox, &sb))) return 0;
+
+    char *dir = strdup(ox->dir);
+    if (!dir) return 0;
+    (void)overlay_scan(ox, dir, reg);
+    free(dir);
+    return 1;
+}
+
+cfg_overlay_t overlay_lookup(const overlay_index_t *ox, const char *token) {
+    if (!ox || !ox->valid || !token) return CFG_OVERLAY_UNCHECKED;
+    const char *key = token;
+    return bsearch(&key, ox->names, ox->count, sizeof(char *), cmp_name) ? CFG_OVERLAY_PRESENT : CFG_OVERLAY_MISSING;
+}
+
+static cfg_overlay_t *label_list(const overlay_index_t *ox, const cfg_intern_t *tokens) {
+    cfg_overlay_t *v = calloc(tokens->count ? tokens->count : 1, sizeof(cfg_overlay_t));
+    if (!v) return NULL;
+    for (uint32_t h = 0; h < tokens->count; h++) v[h] = overlay_lookup(ox, cfg_intern_str(tokens, h));
+    return v;
+}
+
+int overlay_label_state(const overlay_index_t *ox, cfg_state_t *st) {
+    if (!st) return -1;
+    cfg_overlay_t *a = label_list(ox, &st->unknown_interface);
+    cfg_overlay_t *b = label_list(ox, &st->unknown_ext);
+    if (!a || !b) {
+        free(a);
+        free(b);
+        return -1;
+    }
+    free(st->unknown_interface_overlay);
+    free(st->unknown_ext_overlay);
+    st->unknown_interface_overlay = a;
+    st->unknown_ext_overlay = b;
+    return 0;
+}
+
+void overlay_index_free(overlay_index_t *ox) {
+    if (!ox) return;
+    free_names(ox);
+    free(ox->dir);
+    memset(ox, 0, sizeof(*ox));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+
+/*
+ * Index of the .dtbo files U-Boot can load for interface=/ext= tokens.
+ *
+ * The directory is listed with getdents64 once; the result is kept in a
+ * cache file keyed by the directory's device, inode and mtime, so later
+ * starts (and overlay_refresh) only stat the directory. Adding, removing or
+ * renaming an overlay changes the directory mtime and invalidates the cache.
+ */
+
+typedef struct {
+    char *dir;
+    bool valid;             /* the directory was listed; otherwise nothing is known */
+
+    dev_t dev;              /* cache key */
+    ino_t ino;
+    struct timespec mtime;
+
+    char **names;           /* overlay names without ".dtbo", sorted */
+    size_t count;
+
+    cfg_bits_t present;     /* registry items whose overlay exists */
+    size_t *orphans;        /* indices into names[] with no registry item */
+    size_t orphan_count;
+} overlay_index_t;
+
+/* Overlay directory: $SRGN_OVERLAY_DIR, else "overlays" next to the uEnv file */
+const char *overlay_default_dir(const char *uenv_path, char *buf, size_t len);
+
+/* Scan dir (or load the cache). Returns 0; -1 if the directory can't be read
+ * (ox->valid is false then, and every lookup answers CFG_OVERLAY_UNCHECKED). */
+int overlay_scan(overlay_index_t *ox, const char *dir, const cfg_registry_t *reg);
+
+/* Re-stat the directory and rescan if it changed. Returns 1 if rescanned, 0 if not. */
+int overlay_refresh(overlay_index_t *ox, const cfg_registry_t *reg);
+
+cfg_overlay_t overlay_lookup(const overlay_index_t *ox, const char *token);
+
+static inline cfg_overlay_t overlay_item_status(const overlay_index_t *ox, size_t item_index) {
+    if (!ox->valid) return CFG_OVERLAY_UNCHECKED;
+    return cfg_bits_test(&ox->present, item_index) ? CFG_OVERLAY_PRESENT : CFG_OVERLAY_MISSING;
+}
+
+/* Label the unknown tokens of st (cfg_state_t unknown_*_overlay). Returns 0 or -1 on OOM. */
+int overlay_label_state(const overlay_index_t *ox, cfg_state_t *st);
+
+void overlay_index_free(overlay_index_t *ox);
+
+/* Cache file for one kind of data about dir, under $SRGN_CACHE_DIR (default
+ * /run/srgn_config). Returns -1 if caching is disabled ($SRGN_CACHE_DIR=""). */
+int overlay_cache_path(const char *dir, const char *kind, char *buf, size_t len);
+
+/* Open path's temp sibling (tmp) for writing, creating the cache directory;
+ * the caller renames tmp over path once it is complete. */
+FILE *overlay_cache_create(const char *path, char *tmp, size_t tmp_len);
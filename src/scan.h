@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+ * Byte scanning kernel shared by the uEnv parser and AnbUI text splitting.
+ *
+ * All scanners work on an explicit [p, end) range and never read past end,
+ * so vector loads are always in bounds. "Space" follows isspace() in the C
+ * locale (' ', \t, \n, \v, \f, \r) without the locale lookup.
+ *
+ * Newline search goes through memchr (libc already vectorizes it). Token
+ * boundary search uses SSE2 on x86, NEON on ARM when the compiler enables
+ * it, and a word-at-a-time scalar path otherwise.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+# define SCAN_SIMD_SSE2 1
+#elif defined(__ARM_NEON)
+# include <arm_neon.h>
+# define SCAN_SIMD_NEON 1
+#endif
+
+static inline bool scan_is_space(unsigned char c) {
+    return c == ' ' || (unsigned char)(c - '\t') <= ('\r' - '\t');
+}
+
+/* First '\n' in [p, end), or end */
+static inline const char *scan_newline(const char *p, const char *end) {
+    const char *r = (p < end) ? memchr(p, '\n', (size_t)(end - p)) : NULL;
+    return r ? r : end;
+}
+
+/* Number of c bytes in [p, end) */
+static inline size_t scan_count_byte(const char *p, const char *end, char c) {
+    size_t n = 0;
+    while (p < end && (p = memchr(p, c, (size_t)(end - p))) != NULL) {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+/* First non-space byte in [p, end), or end. Runs of blanks are short, so this stays scalar. */
+static inline const char *scan_skip_space(const char *p, const char *end) {
+    while (p < end && scan_is_space((unsigned char)*p)) p++;
+    return p;
+}
+
+/* Same for a NUL-terminated string (NUL is not a space, so it stops there) */
+static inline const char *scan_skip_space_z(const char *p) {
+    while (scan_is_space((unsigned char)*p)) p++;
+    return p;
+}
+
+/* First space byte in [p, end), or end */
+static inline const char *scan_find_space(const char *p, const char *end) {
+#if defined(SCAN_SIMD_SSE2)
+    const __m128i nine = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8('\r' - '\t');
+    const __m128i blank = _mm_set1_epi8(' ');
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+        const __m128i ctl = _mm_cmpeq_epi8(_mm_subs_epu8(_mm_sub_epi8(v, nine), four), _mm_setzero_si128());
+        const int m = _mm_movemask_epi8(_mm_or_si128(ctl, _mm_cmpeq_epi8(v, blank)));
+        if (m) return p + __builtin_ctz((unsigned)m);
+        p += 16;
+    }
+#elif defined(SCAN_SIMD_NEON)
+    const uint8x16_t nine = vdupq_n_u8('\t');
+    const uint8x16_t four = vdupq_n_u8('\r' - '\t');
+    const uint8x16_t blank = vdupq_n_u8(' ');
+    while (end - p >= 16) {
+        const uint8x16_t v = vld1q_u8((const uint8_t *)p);
+        const uint8x16_t hit = vorrq_u8(vcleq_u8(vsubq_u8(v, nine), four), vceqq_u8(v, blank));
+        /* narrow 16 x 8-bit lanes to 16 x 4-bit nibbles in one 64-bit word */
+        const uint64_t m = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hit), 4)), 0);
+        if (m) return p + (__builtin_ctzll(m) >> 2);
+        p += 16;
+    }
+#else
+    /* word-at-a-time: skip words without any byte <= 0x20 (every space is <= 0x20) */
+    const uintptr_t ones = (uintptr_t)-1 / 0xff;
+    while ((size_t)(end - p) >= sizeof(uintptr_t)) {
+        uintptr_t w;
+        memcpy(&w, p, sizeof(w));
+        if (((w - ones * 0x21) & ~w & (ones * 0x80)) != 0) break;
+        p += sizeof(w);
+    }
+#endif
+    while (p < end && !scan_is_space((unsigned char)*p)) p++;
+    return p;
+}
@@ -0,0 +1,88 @@
+#include "startup.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "anbui.h"
+
+static const char *const PHASE_NAMES[STARTUP_PHASE_COUNT] = {"device", "uenv", "terminal", "join", "first_frame"};
+
+static struct timespec s_t0;
+static startup_span_t s_spans[STARTUP_PHASE_COUNT];
+
+static long long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)(ts.tv_sec - s_t0.tv_sec) * 1000000ll + (ts.tv_nsec - s_t0.tv_nsec) / 1000;
+}
+
+/* each phase is written by exactly one thread and read after the join */
+void startup_phase_begin(startup_phase_t ph) {
+    s_spans[ph].start_us = now_us();
+    s_spans[ph].end_us = -1;
+}
+
+void startup_phase_end(startup_phase_t ph) {
+    s_spans[ph].end_us = now_us();
+}
+
+static void *device_worker(void *arg) {
+    startup_t *s = arg;
+    startup_phase_begin(STARTUP_DEVICE);
+    s->device_status = device_info_probe(s->providers, s->provider_count, &s->dev, NULL, s->dev_err,
+                                         sizeof(s->dev_err));
+    startup_phase_end(STARTUP_DEVICE);
+    return NULL;
+}
+
+static void *uenv_worker(void *arg) {
+    startup_t *s = arg;
+    startup_phase_begin(STARTUP_UENV);
+    (void)ui_preload(&s->pre, s->uenv_path);
+    startup_phase_end(STARTUP_UENV);
+    return NULL;
+}
+
+void startup_begin(startup_t *s, const device_provider_t *const *providers, size_t provider_count,
+                   const char *uenv_path) {
+    clock_gettime(CLOCK_MONOTONIC, &s_t0);
+    memset(s_spans, 0xFF, sizeof(s_spans)); /* -1: phase not reached */
+    memset(s, 0, sizeof(*s));
+    s->providers = providers;
+    s->provider_count = provider_count;
+    s->uenv_path = uenv_path;
+
+    s->device_threaded = pthread_create(&s->device_thread, NULL, device_worker, s) == 0;
+    if (!s->device_threaded) device_worker(s);
+    s->uenv_threaded = pthread_create(&s->uenv_thread, NULL, uenv_worker, s) == 0;
+    if (!s->uenv_threaded) uenv_worker(s);
+}
+
+void startup_join(startup_t *s) {
+    startup_phase_begin(STARTUP_JOIN);
+    if (s->device_threaded) pthread_join(s->device_thread, NULL);
+    if (s->uenv_threaded) pthread_join(s->uenv_thread, NULL);
+    s->device_threaded = s->uenv_threaded = false;
+    startup_phase_end(STARTUP_JOIN);
+}
+
+static void write_trace(const char *path) {
+    FILE *fp = fopen(path, "a");
+    if (!fp) return;
+    for (int i = 0; i < STARTUP_PHASE_COUNT; i++) {
+        if (s_spans[i].start_us < 0) continue;
+        fprintf(fp, "{\"phase\":\"%s\",\"start_us\":%lld,\"end_us\":%lld}\n", PHASE_NAMES[i], s_spans[i].start_us,
+                s_spans[i].end_us);
+    }
+    fclose(fp);
+}
+
+void startup_first_frame(void) {
+    ad_setMenuReadyHook(NULL);
+    s_spans[STARTUP_FIRST_FRAME].start_us = 0;
+    s_spans[STARTUP_FIRST_FRAME].end_us = now_us();
+    const char *path = getenv("SRGN_STARTUP_TRACE");
+    if (path && path[0]) write_trace(path);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "device.h"
+#include "ui.h"
+
+/*
+ * Parallel startup. The device probe (possibly a flash read) and the uEnv /
+ * overlay load run on worker threads while the main thread sets up the
+ * terminal and paints the background; startup_join waits for both before
+ * the first menu. Worker results are only touched after the join.
+ *
+ * Every phase is timed from startup_begin. With $SRGN_STARTUP_TRACE set, the
+ * phases are appended to that file as JSON lines when the first menu is on
+ * screen and waiting for input, ending with
+ *   {"phase":"first_frame","start_us":0,"end_us":..}
+ * so time to the first interactive frame can be tracked across builds.
+ */
+
+typedef enum {
+    STARTUP_DEVICE,     /* worker: device_info_probe */
+    STARTUP_UENV,       /* worker: ui_preload */
+    STARTUP_TERMINAL,   /* main: ad_init */
+    STARTUP_JOIN,       /* main: waiting for the workers */
+    STARTUP_FIRST_FRAME,
+    STARTUP_PHASE_COUNT,
+} startup_phase_t;
+
+typedef struct {
+    long long start_us;
+    long long end_us;   /* -1 while running */
+} startup_span_t;
+
+typedef struct {
+    const device_provider_t *const *providers;
+    size_t provider_count;
+    const char *uenv_path;
+
+    pthread_t device_thread;
+    pthread_t uenv_thread;
+    bool device_threaded;
+    bool uenv_threaded;
+
+    /* results, valid after startup_join */
+    int device_status;
+    device_info_t dev;
+    char dev_err[160];
+    ui_preload_t pre;
+} startup_t;
+
+/* Start the workers (or run them inline if a thread cannot be created) */
+void startup_begin(startup_t *s, const device_provider_t *const *providers, size_t provider_count,
+                   const char *uenv_path);
+void startup_join(startup_t *s);
+
+void startup_phase_begin(startup_phase_t ph);
+void startup_phase_end(startup_phase_t ph);
+
+/* Record STARTUP_FIRST_FRAME and write the trace; an ad_setMenuReadyHook
+ * callback, it unregisters itself */
+void startup_first_frame(void);
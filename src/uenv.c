@@ -1,12 +1,15 @@
 #include "uenv.h"
 
-#include <ctype.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include "scan.h"
+
 static void set_err(char *err, size_t err_len, const char *msg) {
     if (err && err_len) {
         snprintf(err, err_len, "%s", msg ? msg : "Unknown error");
@@ -46,14 +49,12 @@ static int strv_push(char ***v, size_t *n, const char *s) {
 }
 
 static char *ltrim(char *s) {
-    while (s && *s && isspace((unsigned char)*s)) s++;
-    return s;
+    return s ? (char *)scan_skip_space_z(s) : s;
 }
 
 static int starts_with_key(const char *line, const char *key) {
     if (!line || !key) return 0;
-    const char *p = line;
-    while (*p && isspace((unsigned char)*p)) p++;
+    const char *p = scan_skip_space_z(line);
     return strncmp(p, key, strlen(key)) == 0;
 }
 
@@ -63,17 +64,17 @@ static int parse_tokens_from_line(const char *line, const char *key, char ***tok
     *count_out = 0;
     if (!line || !key) return 0;
 
-    const char *p = line;
-    while (*p && isspace((unsigned char)*p)) p++;
+    const char *p = scan_skip_space_z(line);
     const size_t klen = strlen(key);
     if (strncmp(p, key, klen) != 0) return 0;
     p += klen;
+    const char *end = p + strlen(p);
 
-    while (*p) {
-        while (*p && isspace((unsigned char)*p)) p++;
-        if (!*p || *p == '\n' || *p == '\r') break;
+    while (p < end) {
+        p = scan_skip_space(p, end);
+        if (p == end) break;
         const char *start = p;
-        while (*p && !isspace((unsigned char)*p) && *p != '\n' && *p != '\r') p++;
+        p = scan_find_space(p, end);
         const size_t len = (size_t)(p - start);
         char tmp[256];
         if (len >= sizeof(tmp)) {
@@ -106,59 +107,222 @@ static int ensure_final_nl(FILE *out, const uenv_file_t *u) {
     return 0;
 }
 
+/* Share prev's token list of an unchanged line with out. prev keeps owning it
+ * until index_keys has fully succeeded, so a failed refresh leaves prev intact. */
+static bool share_tokens(const uenv_file_t *prev, long prev_idx, const char *line,
+                         char **prev_tokens, size_t prev_count,
+                         char ***tokens_out, size_t *count_out) {
+    if (!prev || prev_idx < 0 || (size_t)prev_idx >= prev->line_count) return false;
+    if (strcmp(prev->lines[prev_idx], line) != 0) return false;
+    *tokens_out = prev_tokens;
+    *count_out = prev_count;
+    return true;
+}
+
+/* Find the first interface=/ext= lines (only the first occurrence is treated as authoritative)
+ * and parse their tokens. Token lists of unchanged lines are taken over from prev (if given),
+ * but only once everything else succeeded: on failure prev is untouched and out is freed. */
+static int index_keys(uenv_file_t *out, uenv_file_t *prev, char *err, size_t err_len) {
+    bool shared_interface = false, shared_ext = false;
+    const char *fail = NULL;
+    for (size_t i = 0; i < out->line_count && !fail; i++) {
+        const char *cur = out->lines[i];
+        if (out->interface_idx < 0 && starts_with_key(cur, "interface=")) {
+            out->interface_idx = (long)i;
+            shared_interface = share_tokens(prev, prev ? prev->interface_idx : -1, cur,
+                                            prev ? prev->interface_tokens : NULL, prev ? prev->interface_token_count : 0,
+                                            &out->interface_tokens, &out->interface_token_count);
+            if (!shared_interface &&
+                parse_tokens_from_line(cur, "interface=", &out->interface_tokens, &out->interface_token_count) != 0) {
+                fail = "Failed to parse interface=";
+            }
+        } else if (out->ext_idx < 0 && starts_with_key(cur, "ext=")) {
+            out->ext_idx = (long)i;
+            shared_ext = share_tokens(prev, prev ? prev->ext_idx : -1, cur,
+                                      prev ? prev->ext_tokens : NULL, prev ? prev->ext_token_count : 0,
+                                      &out->ext_tokens, &out->ext_token_count);
+            if (!shared_ext && parse_tokens_from_line(cur, "ext=", &out->ext_tokens, &out->ext_token_count) != 0) {
+                fail = "Failed to parse ext=";
+            }
+        }
+        if (out->interface_idx >= 0 && out->ext_idx >= 0) break;
+    }
+
+    if (fail) {
+        /* shared lists still belong to prev */
+        if (shared_interface) {
+            out->interface_tokens = NULL;
+            out->interface_token_count = 0;
+        }
+        if (shared_ext) {
+            out->ext_tokens = NULL;
+            out->ext_token_count = 0;
+        }
+        uenv_free(out);
+        set_err(err, err_len, fail);
+        return -1;
+    }
+    if (shared_interface) {
+        prev->interface_tokens = NULL;
+        prev->interface_token_count = 0;
+    }
+    if (shared_ext) {
+        prev->ext_tokens = NULL;
+        prev->ext_token_count = 0;
+    }
+    return 0;
+}
+
+static int line_at_equals(const uenv_file_t *a, long ia, const uenv_file_t *b, long ib) {
+    if (ia < 0 || ib < 0) return ia == ib;
+    return strcmp(a->lines[ia], b->lines[ib]) == 0;
+}
+
 int uenv_load(const char *path, uenv_file_t *out, char *err, size_t err_len) {
     if (!out || !path) {
         set_err(err, err_len, "Invalid argument");
         return -1;
     }
-    memset(out, 0, sizeof(*out));
-    out->interface_idx = -1;
-    out->ext_idx = -1;
 
     FILE *fp = fopen(path, "rb");
     if (!fp) {
+        memset(out, 0, sizeof(*out));
+        out->interface_idx = -1;
+        out->ext_idx = -1;
         set_err_errno(err, err_len, "Failed to open uEnv.txt");
         return -1;
     }
 
-    char *line = NULL;
-    size_t cap = 0;
-    ssize_t nread;
-    while ((nread = getline(&line, &cap, fp)) != -1) {
-        (void)nread;
-        if (strv_push(&out->lines, &out->line_count, line) != 0) {
-            free(line);
-            fclose(fp);
+    const int r = uenv_load_fp(fp, out, err, err_len);
+    fclose(fp);
+    return r;
+}
+
+/* Read the whole stream into one buffer (st_size is only a hint: stdin may be a pipe) */
+static char *read_all(FILE *fp, size_t *len_out) {
+    struct stat sb;
+    size_t cap = 4096;
+    if (fstat(fileno(fp), &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        cap = (size_t)sb.st_size + 1;
+    }
+
+    size_t len = 0;
+    char *buf = malloc(cap);
+    if (!buf) return NULL;
+    for (;;) {
+        if (len == cap) {
+            char *nb = realloc(buf, cap * 2);
+            if (!nb) {
+                free(buf);
+                return NULL;
+            }
+            buf = nb;
+            cap *= 2;
+        }
+        const size_t n = fread(buf + len, 1, cap - len, fp);
+        len += n;
+        if (n == 0) break;
+    }
+    *len_out = len;
+    return buf;
+}
+
+static int load_lines(FILE *fp, uenv_file_t *out, char *err, size_t err_len) {
+    size_t len = 0;
+    char *buf = read_all(fp, &len);
+    if (!buf) {
+        set_err(err, err_len, "Out of memory");
+        return -1;
+    }
+    if (ferror(fp)) {
+        free(buf);
+        set_err_errno(err, err_len, "Failed to read uEnv");
+        return -1;
+    }
+
+    /* One allocation for the line table, then one per line */
+    const char *p = buf;
+    const char *end = buf + len;
+    const size_t max_lines = scan_count_byte(p, end, '\n') + 1;
+    out->lines = calloc(max_lines, sizeof(char *));
+    if (!out->lines) {
+        free(buf);
+        set_err(err, err_len, "Out of memory");
+        return -1;
+    }
+
+    while (p < end) {
+        const char *nl = scan_newline(p, end);
+        const char *next = (nl < end) ? nl + 1 : end;
+        const size_t n = (size_t)(next - p);
+        char *line = malloc(n + 1);
+        if (!line) {
+            free(buf);
             uenv_free(out);
             set_err(err, err_len, "Out of memory");
             return -1;
         }
+        memcpy(line, p, n);
+        line[n] = 0;
+        out->lines[out->line_count++] = line;
+        p = next;
     }
 
-    free(line);
+    free(buf);
+    return 0;
+}
+
+int uenv_load_fp(FILE *fp, uenv_file_t *out, char *err, size_t err_len) {
+    if (!out || !fp) {
+        set_err(err, err_len, "Invalid argument");
+        return -1;
+    }
+    memset(out, 0, sizeof(*out));
+    out->interface_idx = -1;
+    out->ext_idx = -1;
+
+    if (load_lines(fp, out, err, err_len) != 0) return -1;
+    return index_keys(out, NULL, err, err_len);
+}
+
+int uenv_refresh(const char *path, uenv_file_t *u, unsigned *changed, char *err, size_t err_len) {
+    if (!path || !u) {
+        set_err(err, err_len, "Invalid argument");
+        return -1;
+    }
+    if (changed) *changed = 0;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        set_err_errno(err, err_len, "Failed to open uEnv.txt");
+        return -1;
+    }
+
+    uenv_file_t n;
+    memset(&n, 0, sizeof(n));
+    n.interface_idx = -1;
+    n.ext_idx = -1;
+    const int r = load_lines(fp, &n, err, err_len);
     fclose(fp);
+    if (r != 0) return -1;
 
-    /* Find the first interface=/ext= lines (only the first occurrence is treated as authoritative) */
-    for (size_t i = 0; i < out->line_count; i++) {
-        const char *cur = out->lines[i];
-        if (out->interface_idx < 0 && starts_with_key(cur, "interface=")) {
-            out->interface_idx = (long)i;
-            if (parse_tokens_from_line(cur, "interface=", &out->interface_tokens, &out->interface_token_count) != 0) {
-                uenv_free(out);
-                set_err(err, err_len, "Failed to parse interface=");
-                return -1;
-            }
-        } else if (out->ext_idx < 0 && starts_with_key(cur, "ext=")) {
-            out->ext_idx = (long)i;
-            if (parse_tokens_from_line(cur, "ext=", &out->ext_tokens, &out->ext_token_count) != 0) {
-                uenv_free(out);
-                set_err(err, err_len, "Failed to parse ext=");
-                return -1;
-            }
-        }
-        if (out->interface_idx >= 0 && out->ext_idx >= 0) break;
+    /* Only interface=/ext= lines whose text changed are re-tokenized */
+    if (index_keys(&n, u, err, err_len) != 0) return -1;
+
+    /* Any line outside interface=/ext= that differs counts as UENV_CHANGED_OTHER */
+    unsigned mask = 0;
+    if (n.line_count != u->line_count) mask |= UENV_CHANGED_OTHER;
+
+    if (!line_at_equals(u, u->interface_idx, &n, n.interface_idx)) mask |= UENV_CHANGED_INTERFACE;
+    if (!line_at_equals(u, u->ext_idx, &n, n.ext_idx)) mask |= UENV_CHANGED_EXT;
+    for (size_t i = 0; !(mask & UENV_CHANGED_OTHER) && i < n.line_count; i++) {
+        if ((long)i == n.interface_idx || (long)i == n.ext_idx) continue;
+        if (strcmp(n.lines[i], u->lines[i]) != 0) mask |= UENV_CHANGED_OTHER;
     }
 
+    uenv_free(u);
+    *u = n;
+    if (changed) *changed = mask;
     return 0;
 }
 
@@ -206,6 +370,41 @@ static int write_kv_line(FILE *out, const char *key, const char *value_line) {
     return 0;
 }
 
+int uenv_write_fp(FILE *out,
+                  const uenv_file_t *u,
+                  const char *interface_line,
+                  const char *ext_line) {
+    if (!out || !u) return -1;
+
+    const long if_idx = u->interface_idx;
+    const long ex_idx = u->ext_idx;
+
+    for (size_t i = 0; i < u->line_count; i++) {
+        if ((long)i == if_idx) {
+            if (write_kv_line(out, "interface=", interface_line) != 0) return -1;
+            continue;
+        }
+        if ((long)i == ex_idx) {
+            if (write_kv_line(out, "ext=", ext_line) != 0) return -1;
+            continue;
+        }
+        if (write_line(out, u->lines[i]) != 0) return -1;
+    }
+
+    /* Append missing keys at end (ensure newline boundary first) */
+    if (if_idx < 0) {
+        if (ensure_final_nl(out, u) != 0) return -1;
+        if (write_kv_line(out, "interface=", interface_line) != 0) return -1;
+    }
+    if (ex_idx < 0) {
+        /* interface= (if appended above) always ends with a newline */
+        if (if_idx >= 0 && ensure_final_nl(out, u) != 0) return -1;
+        if (write_kv_line(out, "ext=", ext_line) != 0) return -1;
+    }
+
+    return 0;
+}
+
 int uenv_write_preserve(const char *path,
                         const uenv_file_t *u,
                         const char *interface_line,
@@ -227,64 +426,11 @@ int uenv_write_preserve(const char *path,
         return -1;
     }
 
-    const long if_idx = u->interface_idx;
-    const long ex_idx = u->ext_idx;
-
-    for (size_t i = 0; i < u->line_count; i++) {
-        if ((long)i == if_idx) {
-            if (write_kv_line(out, "interface=", interface_line) != 0) {
-                fclose(out);
-                unlink(tmp_path);
-                set_err_errno(err, err_len, "Failed to write interface=");
-                return -1;
-            }
-            continue;
-        }
-        if ((long)i == ex_idx) {
-            if (write_kv_line(out, "ext=", ext_line) != 0) {
-                fclose(out);
-                unlink(tmp_path);
-                set_err_errno(err, err_len, "Failed to write ext=");
-                return -1;
-            }
-            continue;
-        }
-        if (write_line(out, u->lines[i]) != 0) {
-            fclose(out);
-            unlink(tmp_path);
-            set_err_errno(err, err_len, "Failed to write file");
-            return -1;
-        }
-    }
-
-    /* Append missing keys at end (ensure newline boundary first) */
-    if (if_idx < 0) {
-        if (ensure_final_nl(out, u) != 0) {
-            fclose(out);
-            unlink(tmp_path);
-            set_err_errno(err, err_len, "Failed to write newline");
-            return -1;
-        }
-        if (write_kv_line(out, "interface=", interface_line) != 0) {
-            fclose(out);
-            unlink(tmp_path);
-            set_err_errno(err, err_len, "Failed to append interface=");
-            return -1;
-        }
-    }
-    if (ex_idx < 0) {
-        if (ensure_final_nl(out, u) != 0) {
-            fclose(out);
-            unlink(tmp_path);
-            set_err_errno(err, err_len, "Failed to write newline");
-            return -1;
-        }
-        if (write_kv_line(out, "ext=", ext_line) != 0) {
-            fclose(out);
-            unlink(tmp_path);
-            set_err_errno(err, err_len, "Failed to append ext=");
-            return -1;
-        }
+    if (uenv_write_fp(out, u, interface_line, ext_line) != 0) {
+        fclose(out);
+        unlink(tmp_path);
+        set_err_errno(err, err_len, "Failed to write file");
+        return -1;
     }
 
     if (fflush(out) != 0) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdio.h>
 
 /*
  * uEnv.txt read/write helper
@@ -28,8 +29,19 @@ typedef struct {
 } uenv_file_t;
 
 int  uenv_load(const char *path, uenv_file_t *out, char *err, size_t err_len);
+/* Same as uenv_load, but reads from an already opened stream (e.g. stdin) */
+int  uenv_load_fp(FILE *fp, uenv_file_t *out, char *err, size_t err_len);
 void uenv_free(uenv_file_t *u);
 
+#define UENV_CHANGED_INTERFACE (1u << 0)
+#define UENV_CHANGED_EXT       (1u << 1)
+#define UENV_CHANGED_OTHER     (1u << 2)
+
+/* Re-read path into u. Token lists of unchanged interface=/ext= lines are kept
+ * instead of re-parsed; *changed receives a UENV_CHANGED_* mask (0 = identical).
+ * On failure u is left as it was. */
+int  uenv_refresh(const char *path, uenv_file_t *u, unsigned *changed, char *err, size_t err_len);
+
 /* Save: preserve everything, only replace/append interface/ext lines */
 int uenv_write_preserve(const char *path,
                         const uenv_file_t *u,
@@ -38,3 +50,9 @@ int uenv_write_preserve(const char *path,
                         char *err,
                         size_t err_len);
 
+/* Stream variant of uenv_write_preserve: no temp file, no rename, no fsync */
+int uenv_write_fp(FILE *out,
+                  const uenv_file_t *u,
+                  const char *interface_line,
+                  const char *ext_line);
+
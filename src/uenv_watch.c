@@ -0,0 +1,67 @@
+#include "uenv_watch.h"
+
+#include <libgen.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define UENV_WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE)
+
+int uenv_watch_open(uenv_watch_t *w, const char *path) {
+    if (!w) return -1;
+    w->fd = -1;
+    w->wd = -1;
+    w->name = NULL;
+    if (!path) return -1;
+
+    char *dir_copy = strdup(path);
+    char *base_copy = strdup(path);
+    if (!dir_copy || !base_copy) {
+        free(dir_copy);
+        free(base_copy);
+        return -1;
+    }
+
+    w->name = strdup(basename(base_copy));
+    free(base_copy);
+    w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (!w->name || w->fd < 0) {
+        free(dir_copy);
+        uenv_watch_close(w);
+        return -1;
+    }
+
+    w->wd = inotify_add_watch(w->fd, dirname(dir_copy), UENV_WATCH_MASK);
+    free(dir_copy);
+    if (w->wd < 0) {
+        uenv_watch_close(w);
+        return -1;
+    }
+    return 0;
+}
+
+bool uenv_watch_changed(uenv_watch_t *w) {
+    if (!w || w->fd < 0) return false;
+
+    bool changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(w->fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            if (ev->len && strcmp(ev->name, w->name) == 0) changed = true;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
+
+void uenv_watch_close(uenv_watch_t *w) {
+    if (!w) return;
+    if (w->fd >= 0) close(w->fd);
+    free(w->name);
+    w->fd = -1;
+    w->wd = -1;
+    w->name = NULL;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+
+/*
+ * inotify watch on uEnv.txt.
+ *
+ * The parent directory is watched (not the file itself) because writers such
+ * as uenv_write_preserve replace the file with rename(), which would silently
+ * drop a watch on the old inode. The fd is non-blocking: pending events are
+ * queued by the kernel and drained at UI decision points, nothing is polled.
+ */
+
+typedef struct {
+    int   fd;
+    int   wd;
+    char *name; /* basename of the watched file */
+} uenv_watch_t;
+
+/* Returns 0 on success; on failure w->fd is -1 and the watch is a no-op. */
+int  uenv_watch_open(uenv_watch_t *w, const char *path);
+/* Drain queued events; true if any of them touched the watched file. */
+bool uenv_watch_changed(uenv_watch_t *w);
+void uenv_watch_close(uenv_watch_t *w);
@@ -6,53 +6,125 @@
 
 #include "anbui.h"
 
+#include "config_history.h"
+#include "config_profile.h"
 #include "config_registry.h"
 #include "config_state.h"
+#include "overlay_pins.h"
+#include "overlay_scan.h"
 #include "uenv.h"
+#include "uenv_watch.h"
+
+typedef struct {
+    const char *uenv_path;
+    device_rev_t dev_rev;
+    uenv_file_t u;      /* on-disk baseline */
+    cfg_state_t st;     /* edited state */
+    bool dirty;         /* st has edits not yet written */
+    cfg_history_t history;
+    cfg_snapshot_t saved; /* st as on disk; stale if a foreign change was not reloaded */
+    bool saved_valid;
+    uenv_watch_t watch;
+    overlay_view_t view; /* .dtbo files next to uEnv.txt and the registry derived from them */
+    cfg_lines_t lines; /* serialized interface=/ext= lines, reused across saves */
+} ui_ctx_t;
 
 static int confirm_yesno(const char *title, const char *prompt) {
     const int32_t r = ad_yesNoBox(title ? title : "Confirm", true, "%s", prompt ? prompt : "");
     return (r == AD_YESNO_YES) ? 0 : 1;
 }
 
-static void free_strv(char **v, size_t n) {
-    if (!v) return;
-    for (size_t i = 0; i < n; i++) free(v[i]);
-    free(v);
+/* st now matches uEnv.txt on disk */
+static void mark_saved(ui_ctx_t *ctx) {
+    cfg_snapshot_take(&ctx->st, &ctx->saved);
+    ctx->saved_valid = true;
+    ctx->dirty = false;
 }
 
-static char *join_tokens(char *const *tokens, size_t n) {
-    /* join with single spaces, no trailing space */
-    size_t len = 0;
-    for (size_t i = 0; i < n; i++) {
-        if (!tokens[i] || tokens[i][0] == 0) continue;
-        len += strlen(tokens[i]) + 1;
+/* After every edit. An edit that added an unknown token may have reissued
+ * hidden handles, which makes older snapshots name other tokens: drop them. */
+static void update_dirty(ui_ctx_t *ctx) {
+    cfg_history_drop_stale(&ctx->history, &ctx->st);
+    if (ctx->saved_valid && !cfg_snapshot_valid(&ctx->st, &ctx->saved)) ctx->saved_valid = false;
+    cfg_snapshot_t cur;
+    cfg_snapshot_take(&ctx->st, &cur);
+    ctx->dirty = !ctx->saved_valid || !cfg_snapshot_equal(&cur, &ctx->saved);
+}
+
+static int reload_state(ui_ctx_t *ctx) {
+    cfg_state_t nst;
+    if (cfg_state_init_from_uenv(&nst, ctx->st.reg, &ctx->u, ctx->dev_rev) != 0) return -1;
+    if (overlay_label_state(&ctx->view.overlays, &nst) != 0) {
+        cfg_state_free(&nst);
+        return -1;
     }
-    if (len == 0) return strdup("");
+    cfg_state_free(&ctx->st);
+    ctx->st = nst;
+    mark_saved(ctx);
+    cfg_history_clear(&ctx->history); /* handles in the old snapshots belong to the old state */
+    return 0;
+}
 
-    char *buf = calloc(1, len);
-    if (!buf) return NULL;
-    size_t off = 0;
-    for (size_t i = 0; i < n; i++) {
-        if (!tokens[i] || tokens[i][0] == 0) continue;
-        const size_t tlen = strlen(tokens[i]);
-        if (off != 0) buf[off++] = ' ';
-        memcpy(buf + off, tokens[i], tlen);
-        off += tlen;
-        buf[off] = 0;
-    }
-    return buf;
+/*
+ * Pick up changes another process made to uEnv.txt. The baseline is always
+ * refreshed so a later save preserves foreign edits to other lines. If the
+ * interface=/ext= lines changed, the edited state is reloaded automatically
+ * when there are no local edits; otherwise the user decides.
+ */
+static void check_external_change(ui_ctx_t *ctx) {
+    /* st keeps indexing the same items whichever registry it points at */
+    if (overlay_view_refresh(&ctx->view, ctx->dev_rev)) {
+        ctx->st.reg = overlay_view_registry(&ctx->view);
+        (void)overlay_label_state(&ctx->view.overlays, &ctx->st);
+    }
+
+    if (!uenv_watch_changed(&ctx->watch)) return;
+
+    char err[256];
+    unsigned changed = 0;
+    if (uenv_refresh(ctx->uenv_path, &ctx->u, &changed, err, sizeof(err)) != 0) {
+        ad_okBox("Warning", true, "uEnv.txt changed on disk,\nbut re-reading it failed: %s", err);
+        return;
+    }
+    if (!(changed & (UENV_CHANGED_INTERFACE | UENV_CHANGED_EXT))) return;
+
+    const bool had_edits = ctx->dirty;
+    if (had_edits) {
+        const int32_t r = ad_yesNoBox("Conflict", true,
+                                      "uEnv.txt was changed by another process.\n"
+                                      "Discard your unsaved changes\nand reload it?");
+        if (r != AD_YESNO_YES) {
+            ctx->saved_valid = false;
+            return;
+        }
+    }
+    if (reload_state(ctx) != 0) {
+        ad_okBox("Error", true, "Failed to reload config state \n(OOM or internal error).");
+        return;
+    }
+    if (!had_edits) {
+        ad_okBox("Info", true, "uEnv.txt was changed by another process.\nConfiguration reloaded.");
+    }
 }
 
-static int run_category_menu(cfg_state_t *st,
-                             device_rev_t dev_rev,
+/* Hotkeys in the category menus. No Ctrl-Z / Ctrl-Y: the tty keeps ISIG, so
+ * they are job control (SUSP / DSUSP) and never reach the menu. */
+#define UNDO_KEYS "uU"
+#define REDO_KEYS "rR"
+
+static int run_category_menu(ui_ctx_t *ctx,
                              cfg_category_t cat,
                              const char *title) {
-    if (!st || !st->reg) return -1;
+    cfg_state_t *st = &ctx->st;
+    const device_rev_t dev_rev = ctx->dev_rev;
+    if (!st->reg) return -1;
 
     while (1) {
-        ad_Menu *menu = ad_menuCreate(title, "Press ENTER/3 to toggle; \nESC/4 to go back.", true);
+        check_external_change(ctx);
+
+        ad_Menu *menu = ad_menuCreate(title, "Press ENTER/3 to toggle; \nU to undo, R to redo; \nESC/4 to go back.", true);
         if (!menu) return -1;
+        ad_menuSetHotkeys(menu, UNDO_KEYS REDO_KEYS);
 
         /* build a mapping from visible menu index -> registry index */
         size_t *map = NULL;
@@ -62,12 +134,21 @@ static int run_category_menu(cfg_state_t *st,
             const cfg_item_t *it = &st->reg->items[i];
             if (it->cat != cat) continue;
 
-            const bool enabled = st->enabled[i];
+            const bool enabled = cfg_state_is_enabled(st, i);
             const bool avail = cfg_item_is_available(it, dev_rev);
 
+            const cfg_bits_t users = cfg_state_dependents(st, i);
+            const size_t user_count = cfg_bits_count(&users);
+
             char line[256];
             if (!avail) {
                 snprintf(line, sizeof(line), "[%c] %s (unavailable)", enabled ? 'x' : ' ', it->title);
+            } else if (overlay_item_status(&ctx->view.overlays, i) == CFG_OVERLAY_MISSING) {
+                snprintf(line, sizeof(line), "[%c] %s (no .dtbo)", enabled ? 'x' : ' ', it->title);
+            } else if (enabled && user_count == 1) {
+                snprintf(line, sizeof(line), "[x] %s (needed by %s)", it->title, st->reg->items[cfg_bits_next(&users, 0)].id);
+            } else if (enabled && user_count > 1) {
+                snprintf(line, sizeof(line), "[x] %s (needed by %zu items)", it->title, user_count);
             } else {
                 snprintf(line, sizeof(line), "[%c] %s", enabled ? 'x' : ' ', it->title);
             }
@@ -83,12 +164,42 @@ static int run_category_menu(cfg_state_t *st,
             map[map_count++] = i;
         }
 
+        /* tokens kept from uEnv.txt that the registry doesn't know: shown, not editable */
+        const cfg_intern_t *unknown = cfg_state_unknown(st, cat);
+        const cfg_overlay_t *labels = (cat == CFG_CAT_INTERFACE) ? st->unknown_interface_overlay : st->unknown_ext_overlay;
+        const size_t unknown_count = unknown->count;
+        for (size_t k = 0; k < unknown_count; k++) {
+            const cfg_overlay_t ov = labels ? labels[k] : CFG_OVERLAY_UNCHECKED;
+            ad_menuAddItemFormatted(menu, "[x] %s (%s)", cfg_intern_str(unknown, (uint32_t)k),
+                                    ov == CFG_OVERLAY_MISSING ? "unknown, no .dtbo" : "unknown");
+        }
+
         const int32_t sel = ad_menuExecute(menu);
+        const uint32_t key = ad_menuGetHotkey(menu);
         ad_menuDestroy(menu);
         if (sel == AD_CANCELED) {
             free(map);
             return 0;
         }
+        if (sel == AD_HOTKEY) {
+            free(map);
+            const bool undo = strchr(UNDO_KEYS, (int)key) != NULL;
+            if ((undo ? cfg_history_undo(&ctx->history, st) : cfg_history_redo(&ctx->history, st)) != 0) {
+                ad_okBox("Info", true, undo ? "Nothing to undo." : "Nothing to redo.");
+            }
+            update_dirty(ctx);
+            (void)overlay_label_state(&ctx->view.overlays, st); /* labels follow the visible unknown tokens */
+            continue;
+        }
+        if (sel >= 0 && (size_t)sel >= map_count && (size_t)sel < map_count + unknown_count) {
+            const size_t k = (size_t)sel - map_count;
+            const bool missing = labels && labels[k] == CFG_OVERLAY_MISSING;
+            free(map);
+            ad_okBox("Info", true, "%s is not in the registry.\nIt is kept in uEnv.txt as is.%s",
+                     cfg_intern_str(unknown, (uint32_t)k),
+                     missing ? "\n\nNo matching .dtbo was found\nin the overlay directory." : "");
+            continue;
+        }
         if (sel < 0 || (size_t)sel >= map_count) {
             free(map);
             continue;
@@ -103,35 +214,262 @@ static int run_category_menu(cfg_state_t *st,
             continue;
         }
 
+        cfg_snapshot_t before;
+        cfg_snapshot_take(st, &before);
         const int r = cfg_state_toggle(st, idx, dev_rev, confirm_yesno);
-        if (r == -2) {
+        if (r == 0) {
+            cfg_history_push(&ctx->history, &before);
+            update_dirty(ctx);
+        } else if (r == -2) {
             ad_okBox("Info", true, "This option is unavailable \non the current device revision.");
         } else if (r == -4) {
-            /* user rejected disabling conflicts */
+            /* user rejected disabling conflicts / dependents */
             ad_okBox("Info", true, "Operation cancelled.");
-        } else if (r != 0) {
+        } else {
             ad_okBox("Error", true, "Toggle failed (internal error).");
         }
     }
 }
 
-int ui_run(const device_info_t *dev_info, const char *uenv_path) {
-    if (!dev_info || !uenv_path) return -1;
+/* Enabled tokens (known or not) whose overlay is missing; returns how many */
+static size_t list_missing_overlays(const ui_ctx_t *ctx, char *buf, size_t len) {
+    const cfg_state_t *st = &ctx->st;
+    size_t n = 0;
+    size_t off = 0;
+    buf[0] = 0;
+#define ADD_MISSING(name)                                                                         \
+    do {                                                                                          \
+        n++;                                                                                      \
+        if (off < len) off += (size_t)snprintf(buf + off, len - off, "%s%s", off ? " " : "", name); \
+    } while (0)
+    for (size_t i = cfg_bits_next(&st->enabled, 0); i < CFG_MAX_ITEMS; i = cfg_bits_next(&st->enabled, i + 1)) {
+        if (overlay_item_status(&ctx->view.overlays, i) == CFG_OVERLAY_MISSING) ADD_MISSING(st->reg->items[i].id);
+    }
+    for (uint32_t h = 0; st->unknown_interface_overlay && h < st->unknown_interface.count; h++) {
+        if (st->unknown_interface_overlay[h] == CFG_OVERLAY_MISSING) ADD_MISSING(cfg_intern_str(&st->unknown_interface, h));
+    }
+    for (uint32_t h = 0; st->unknown_ext_overlay && h < st->unknown_ext.count; h++) {
+        if (st->unknown_ext_overlay[h] == CFG_OVERLAY_MISSING) ADD_MISSING(cfg_intern_str(&st->unknown_ext, h));
+    }
+#undef ADD_MISSING
+    return n;
+}
+
+/* Overlay directory report: registry items without a .dtbo, .dtbo files without a registry item */
+static void show_overlays(ui_ctx_t *ctx) {
+    const overlay_index_t *ox = &ctx->view.overlays;
+    if (!ox->valid) {
+        ad_okBox("Overlays", true, "Overlay directory %s\ncould not be read.", ox->dir ? ox->dir : "(none)");
+        return;
+    }
+
+    char prompt[300];
+    snprintf(prompt, sizeof(prompt), "%s: %zu overlays\nESC/4 to go back.", ox->dir, ox->count);
+    ad_Menu *menu = ad_menuCreate("Overlays", prompt, true);
+    if (!menu) return;
+    size_t rows = 0;
+    for (size_t i = 0; i < ctx->st.reg->count; i++) {
+        if (overlay_item_status(ox, i) != CFG_OVERLAY_MISSING) continue;
+        ad_menuAddItemFormatted(menu, "missing: %s.dtbo", ctx->st.reg->items[i].id);
+        rows++;
+    }
+    for (size_t k = 0; k < ox->orphan_count; k++) {
+        ad_menuAddItemFormatted(menu, "not in registry: %s.dtbo", ox->names[ox->orphans[k]]);
+        rows++;
+    }
+    for (size_t i = 0; ctx->view.derived_valid && i < ctx->st.reg->count; i++) {
+        if (!cfg_bits_test(&ctx->view.derived.differs, i)) continue;
+        ad_menuAddItemFormatted(menu, "pins differ from table: %s.dtbo", ctx->st.reg->items[i].id);
+        rows++;
+    }
+    if (rows == 0) ad_menuAddItemFormatted(menu, "Every registry item has an overlay.");
+    (void)ad_menuExecute(menu);
+    ad_menuDestroy(menu);
+}
+
+/* Stored profiles (config_profile.h); applying one is a single undoable edit */
+static void apply_profile(ui_ctx_t *ctx) {
+    char **names = NULL;
+    const int count = cfg_profile_list(&names);
+    if (count <= 0) {
+        ad_okBox("Profiles", true, "No profiles in %s.\nCreate them with\nsrgn_config --filter --save-profile.", cfg_profile_dir());
+        return;
+    }
+    ad_Menu *menu = ad_menuCreate("Profiles", "Select a profile to apply.\nESC/4 to go back.", true);
+    if (!menu) {
+        cfg_profile_list_free(names, count);
+        return;
+    }
+    for (int i = 0; i < count; i++) ad_menuAddItemFormatted(menu, "%s", names[i]);
+    const int32_t sel = ad_menuExecute(menu);
+    ad_menuDestroy(menu);
 
     char err[256];
-    uenv_file_t u = {0};
-    if (uenv_load(uenv_path, &u, err, sizeof(err)) != 0) {
-        ad_okBox("Error", true, "Failed to read config: %s", err);
+    cfg_profile_t p;
+    const int loaded = (sel >= 0 && sel < count) ? cfg_profile_load(names[sel], &p, err, sizeof(err)) : 1;
+    cfg_profile_list_free(names, count);
+    if (loaded > 0) return;
+    if (loaded < 0) {
+        ad_okBox("Error", true, "%s", err);
+        return;
+    }
+
+    char code[128];
+    const bool short_code = cfg_profile_export(&p, code, sizeof(code)) < sizeof(code);
+    if (ad_yesNoBox("Profile", true, "Apply profile %s?\nMade on %s.\n\nCode: %s", p.name, get_device_rev_str(p.rev),
+                    short_code ? code : "(too long to show)") != AD_YESNO_YES) {
+        cfg_profile_free(&p);
+        return;
+    }
+
+    cfg_snapshot_t before;
+    cfg_snapshot_take(&ctx->st, &before);
+    int r = cfg_profile_apply(&ctx->st, &p, ctx->dev_rev, false, NULL, err, sizeof(err));
+    if (r == -4 && ad_yesNoBox("Profile", true, "%s\n\nApply the parts that fit?", err) == AD_YESNO_YES) {
+        r = cfg_profile_apply(&ctx->st, &p, ctx->dev_rev, true, NULL, err, sizeof(err));
+    }
+    cfg_profile_free(&p);
+    if (r == -1) ad_okBox("Error", true, "%s", err);
+    if (r != 0) return;
+
+    cfg_history_push(&ctx->history, &before);
+    update_dirty(ctx);
+    (void)overlay_label_state(&ctx->view.overlays, &ctx->st); /* the profile may bring unknown tokens */
+}
+
+/* The baseline's interface=/ext= lines are the ones last rendered into ctx->lines */
+static bool rendered_on_disk(const ui_ctx_t *ctx) {
+    const uenv_file_t *u = &ctx->u;
+    return u->interface_idx >= 0 && u->ext_idx >= 0 &&
+           strcmp(u->lines[u->interface_idx], ctx->lines.interface_line) == 0 &&
+           strcmp(u->lines[u->ext_idx], ctx->lines.ext_line) == 0;
+}
+
+static void save_changes(ui_ctx_t *ctx) {
+    char err[256];
+
+    /* last chance to notice a foreign write before overwriting it */
+    check_external_change(ctx);
+
+    /* a broken config would only show up after a reboot; never write one */
+    if (cfg_state_validate(&ctx->st, ctx->dev_rev, err, sizeof(err)) != 0) {
+        ad_okBox("Error", true, "Configuration is invalid:\n%s\n\nNot saved.", err);
+        return;
+    }
+
+    /* U-Boot would fail to apply these; let the user decide before rebooting into it */
+    char missing[256];
+    if (list_missing_overlays(ctx, missing, sizeof(missing)) > 0) {
+        const int32_t r = ad_yesNoBox("Warning", true, "No .dtbo found in %s for:\n%s\n\nSave anyway?",
+                                      ctx->view.overlays.dir, missing);
+        if (r != AD_YESNO_YES) return;
+    }
+
+    if (cfg_state_render(&ctx->st, &ctx->lines) != 0) {
+        ad_okBox("Error", true, "Failed to build output \n(OOM or internal error).");
+        return;
+    }
+
+    if (uenv_write_preserve(ctx->uenv_path, &ctx->u, ctx->lines.interface_line, ctx->lines.ext_line, err,
+                            sizeof(err)) != 0) {
+        ad_okBox("Error", true, "Write failed: %s", err);
+    } else {
+        /* Drain our own rename() event and read the file back before any dialog:
+         * a later write is then either in this read or still queued for
+         * check_external_change, never folded silently into the baseline. */
+        (void)uenv_watch_changed(&ctx->watch);
+        if (uenv_refresh(ctx->uenv_path, &ctx->u, NULL, err, sizeof(err)) != 0) {
+            mark_saved(ctx);
+            ad_okBox("Warning", true, "Write succeeded, but reload failed: %s", err);
+            return;
+        }
+        if (!rendered_on_disk(ctx)) {
+            /* another process wrote in between; its lines win, as in check_external_change */
+            if (reload_state(ctx) != 0) {
+                ad_okBox("Error", true, "Failed to reload config state \n(OOM or internal error).");
+                return;
+            }
+            ad_okBox("Info", true, "uEnv.txt was changed by another process\nright after saving.\nConfiguration reloaded.");
+            return;
+        }
+        mark_saved(ctx);
+        ad_okBox("Done", true, "Written to %s.\nReboot is required \nfor changes to take effect.", ctx->uenv_path);
+    }
+}
+
+/* Back to what uEnv.txt holds. The current state goes on the undo stack, so this is undoable too. */
+static void revert_changes(ui_ctx_t *ctx) {
+    if (!ctx->dirty) {
+        ad_okBox("Info", true, "No unsaved changes.");
+        return;
+    }
+    cfg_snapshot_t cur;
+    cfg_snapshot_take(&ctx->st, &cur);
+    if (ctx->saved_valid && cfg_snapshot_restore(&ctx->st, &ctx->saved) == 0) {
+        cfg_history_push(&ctx->history, &cur);
+        ctx->dirty = false;
+        (void)overlay_label_state(&ctx->view.overlays, &ctx->st);
+    } else if (reload_state(ctx) != 0) {
+        /* the on-disk lines changed under us, or saved went stale; only a re-parse knows them */
+        ad_okBox("Error", true, "Failed to reload config state \n(OOM or internal error).");
+        return;
+    }
+    ad_okBox("Done", true, "Reverted to %s.", ctx->uenv_path);
+}
+
+int ui_preload(ui_preload_t *pre, const char *uenv_path) {
+    memset(pre, 0, sizeof(*pre));
+    if (uenv_load(uenv_path, &pre->u, pre->err, sizeof(pre->err)) != 0) {
+        pre->status = -1;
+        return -1;
+    }
+    /* without the overlay directory nothing is labeled and the table's pins are used */
+    (void)overlay_view_scan(&pre->view, uenv_path);
+    return 0;
+}
+
+void ui_preload_free(ui_preload_t *pre) {
+    if (!pre) return;
+    overlay_view_free(&pre->view);
+    uenv_free(&pre->u);
+    memset(pre, 0, sizeof(*pre));
+}
+
+int ui_run(const device_info_t *dev_info, const char *uenv_path, ui_preload_t *pre) {
+    if (!dev_info || !uenv_path) return -1;
+
+    ui_preload_t local;
+    if (!pre) {
+        (void)ui_preload(&local, uenv_path);
+        pre = &local;
+    }
+    if (pre->status != 0) {
+        ad_okBox("Error", true, "Failed to read config: %s", pre->err);
+        ui_preload_free(pre);
         return -1;
     }
 
-    const cfg_registry_t *reg = cfg_registry_get();
-    cfg_state_t st;
-    if (cfg_state_init_from_uenv(&st, reg, &u, dev_info->rev) != 0) {
-        uenv_free(&u);
+    ui_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.uenv_path = uenv_path;
+    ctx.dev_rev = dev_info->rev;
+    ctx.u = pre->u;
+    ctx.view = pre->view;
+    memset(pre, 0, sizeof(*pre));
+    (void)overlay_view_refresh(&ctx.view, ctx.dev_rev);
+
+    const cfg_registry_t *reg = overlay_view_registry(&ctx.view);
+    if (!reg || cfg_state_init_from_uenv(&ctx.st, reg, &ctx.u, dev_info->rev) != 0) {
+        overlay_view_free(&ctx.view);
+        uenv_free(&ctx.u);
         ad_okBox("Error", true, "Failed to initialize config state \n(OOM or internal error).");
         return -1;
     }
+    (void)overlay_label_state(&ctx.view.overlays, &ctx.st);
+    mark_saved(&ctx);
+
+    /* without inotify the tool still works, it just can't notice foreign writes */
+    (void)uenv_watch_open(&ctx.watch, uenv_path);
 
     char prompt[512];
     snprintf(prompt, sizeof(prompt),
@@ -141,76 +479,52 @@ int ui_run(const device_info_t *dev_info, const char *uenv_path) {
              uenv_path);
 
     while (1) {
+        check_external_change(&ctx);
+
         ad_Menu *menu = ad_menuCreate("srgn_config V0.1", prompt, true);
         if (!menu) break;
         ad_menuAddItemFormatted(menu, "Configure interfaces (interface)");
         ad_menuAddItemFormatted(menu, "Configure extensions (ext)");
         ad_menuAddItemFormatted(menu, "View uEnv.txt");
+        ad_menuAddItemFormatted(menu, "Check overlays");
+        ad_menuAddItemFormatted(menu, "Apply profile");
         ad_menuAddItemFormatted(menu, "Save changes");
+        ad_menuAddItemFormatted(menu, "Revert to saved");
         ad_menuAddItemFormatted(menu, "Reboot");
         ad_menuAddItemFormatted(menu, "Exit");
 
         const int32_t sel = ad_menuExecute(menu);
         ad_menuDestroy(menu);
 
-        if (sel == AD_CANCELED || sel == 5) {
+        if (sel == AD_CANCELED || sel == 8) {
             break;
         }
 
         if (sel == 0) {
-            run_category_menu(&st, dev_info->rev, CFG_CAT_INTERFACE, "Interfaces (interface)");
+            run_category_menu(&ctx, CFG_CAT_INTERFACE, "Interfaces (interface)");
         } else if (sel == 1) {
-            run_category_menu(&st, dev_info->rev, CFG_CAT_EXT, "Extensions (ext)");
+            run_category_menu(&ctx, CFG_CAT_EXT, "Extensions (ext)");
         } else if (sel == 2) {
             ad_textFileBox("uEnv.txt", uenv_path);
         } else if (sel == 3) {
-            char **if_tokens = NULL;
-            size_t if_count = 0;
-            char **ex_tokens = NULL;
-            size_t ex_count = 0;
-
-            if (cfg_state_build_tokens(&st, CFG_CAT_INTERFACE, &if_tokens, &if_count) != 0 ||
-                cfg_state_build_tokens(&st, CFG_CAT_EXT, &ex_tokens, &ex_count) != 0) {
-                free_strv(if_tokens, if_count);
-                free_strv(ex_tokens, ex_count);
-                ad_okBox("Error", true, "Failed to build output \n(OOM or internal error).");
-                continue;
-            }
-
-            char *if_joined = join_tokens(if_tokens, if_count);
-            char *ex_joined = join_tokens(ex_tokens, ex_count);
-            free_strv(if_tokens, if_count);
-            free_strv(ex_tokens, ex_count);
-
-            if (!if_joined || !ex_joined) {
-                free(if_joined);
-                free(ex_joined);
-                ad_okBox("Error", true, "Out of memory.");
-                continue;
-            }
-
-            if (uenv_write_preserve(uenv_path, &u, if_joined, ex_joined, err, sizeof(err)) != 0) {
-                ad_okBox("Error", true, "Write failed: %s", err);
-            } else {
-                ad_okBox("Done", true, "Written to %s.\nReboot is required \nfor changes to take effect.", uenv_path);
-                /* Reload to refresh baseline and parsed tokens */
-                uenv_free(&u);
-                if (uenv_load(uenv_path, &u, err, sizeof(err)) != 0) {
-                    ad_okBox("Warning", true, "Write succeeded, but reload failed: %s", err);
-                }
-            }
-
-            free(if_joined);
-            free(ex_joined);
+            show_overlays(&ctx);
+        } else if (sel == 4) {
+            apply_profile(&ctx);
+        } else if (sel == 5) {
+            save_changes(&ctx);
+        } else if (sel == 6) {
+            revert_changes(&ctx);
         }
-        if (sel == 4) {
+        if (sel == 7) {
             system("reboot");
             break;
         }
     }
 
-    cfg_state_free(&st);
-    uenv_free(&u);
+    uenv_watch_close(&ctx.watch);
+    cfg_state_free(&ctx.st);
+    overlay_view_free(&ctx.view);
+    cfg_lines_free(&ctx.lines);
+    uenv_free(&ctx.u);
     return 0;
 }
-
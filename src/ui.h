@@ -1,7 +1,23 @@
 #pragma once
 
+#include "config_registry.h"
 #include "device.h"
+#include "overlay_pins.h"
+#include "uenv.h"
 
-/* Return 0 on normal exit; non-zero on error (UI already displayed the message). */
-int ui_run(const device_info_t *dev_info, const char *uenv_path);
+/* Startup work that needs neither the terminal nor the device identity, so
+ * it can run on a worker thread while the screen is being set up */
+typedef struct {
+    int status;         /* 0, or -1 with err set */
+    char err[256];
+    uenv_file_t u;
+    overlay_view_t view; /* scanned, not derived yet: that needs the revision */
+} ui_preload_t;
+
+int  ui_preload(ui_preload_t *pre, const char *uenv_path);
+void ui_preload_free(ui_preload_t *pre);
+
+/* pre may be NULL (ui_run loads itself); otherwise ui_run takes over its contents.
+ * Return 0 on normal exit; non-zero on error (UI already displayed the message). */
+int ui_run(const device_info_t *dev_info, const char *uenv_path, ui_preload_t *pre);
 
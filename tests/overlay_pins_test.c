@@ -0,0 +1,302 @@
+/*
+ * overlay_pins_test: conflicts derived from .dtbo blobs
+ *
+ * Writes minimal overlays into a temporary directory (a bus, two devices on
+ * that bus that repeat its pin group, and a UART) and checks the derived
+ * registry on every revision: the bus and its devices don't conflict, the
+ * devices don't conflict with each other, a real pin overlap still does, and
+ * "interface=i2c0 / ext=cardkb" validates and can be toggled.
+ *
+ * Exit codes: 0 pass, 1 failures, 2 setup error.
+ */
+
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config_registry.h"
+#include "config_state.h"
+#include "overlay_pins.h"
+#include "overlay_scan.h"
+#include "uenv.h"
+
+/* ---- tiny flattened device tree writer ---- */
+
+#define FDT_BEGIN_NODE 1u
+#define FDT_END_NODE   2u
+#define FDT_PROP       3u
+#define FDT_END        9u
+
+typedef struct {
+    unsigned char st[2048];
+    uint32_t st_len;
+    char strings[512];
+    uint32_t strings_len;
+} blob_t;
+
+static void put32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void emit32(blob_t *b, uint32_t v) {
+    put32(b->st + b->st_len, v);
+    b->st_len += 4;
+}
+
+static void emit_bytes(blob_t *b, const void *data, uint32_t len) {
+    memcpy(b->st + b->st_len, data, len);
+    b->st_len += len;
+    while (b->st_len % 4) b->st[b->st_len++] = 0;
+}
+
+static void begin_node(blob_t *b, const char *name) {
+    emit32(b, FDT_BEGIN_NODE);
+    emit_bytes(b, name, (uint32_t)strlen(name) + 1);
+}
+
+static void end_node(blob_t *b) {
+    emit32(b, FDT_END_NODE);
+}
+
+static void prop(blob_t *b, const char *name, const void *data, uint32_t len) {
+    uint32_t off = 0;
+    while (off < b->strings_len && strcmp(b->strings + off, name) != 0) off += (uint32_t)strlen(b->strings + off) + 1;
+    if (off == b->strings_len) {
+        memcpy(b->strings + off, name, strlen(name) + 1);
+        b->strings_len += (uint32_t)strlen(name) + 1;
+    }
+    emit32(b, FDT_PROP);
+    emit32(b, len);
+    emit32(b, off);
+    emit_bytes(b, data, len);
+}
+
+static void prop_str(blob_t *b, const char *name, const char *s) {
+    prop(b, name, s, (uint32_t)strlen(s) + 1);
+}
+
+static void prop_u32(blob_t *b, const char *name, uint32_t v) {
+    unsigned char d[4];
+    put32(d, v);
+    prop(b, name, d, sizeof(d));
+}
+
+/* "pins" string list from a NULL-terminated argument list */
+static void prop_pins(blob_t *b, const char *name, ...) {
+    char list[128];
+    uint32_t len = 0;
+    va_list ap;
+    va_start(ap, name);
+    for (const char *p; (p = va_arg(ap, const char *));) {
+        memcpy(list + len, p, strlen(p) + 1);
+        len += (uint32_t)strlen(p) + 1;
+    }
+    va_end(ap);
+    prop(b, name, list, len);
+}
+
+/* fragment@N { target = <unresolved>; __overlay__ { ... } } is left open at __overlay__ */
+static void begin_fragment(blob_t *b, int n) {
+    char name[32];
+    snprintf(name, sizeof(name), "fragment@%d", n);
+    begin_node(b, name);
+    prop_u32(b, "target", 0xffffffffu);
+    begin_node(b, "__overlay__");
+}
+
+static void end_fragment(blob_t *b) {
+    end_node(b);
+    end_node(b);
+}
+
+static int write_blob(const char *dir, const char *name, blob_t *b) {
+    emit32(b, FDT_END);
+    const uint32_t off_struct = 40 + 16; /* header, empty memory reservation map */
+    const uint32_t off_strings = off_struct + b->st_len;
+    const uint32_t total = off_strings + b->strings_len;
+    unsigned char *out = calloc(1, total);
+    if (!out) return -1;
+    put32(out + 0, 0xd00dfeedu);
+    put32(out + 4, total);
+    put32(out + 8, off_struct);
+    put32(out + 12, off_strings);
+    put32(out + 16, 40);
+    put32(out + 20, 17);
+    put32(out + 24, 16);
+    put32(out + 32, b->strings_len);
+    put32(out + 36, b->st_len);
+    memcpy(out + off_struct, b->st, b->st_len);
+    memcpy(out + off_strings, b->strings, b->strings_len);
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.dtbo", dir, name);
+    FILE *fp = fopen(path, "wb");
+    int r = (fp && fwrite(out, 1, total, fp) == total) ? 0 : -1;
+    if (fp && fclose(fp) != 0) r = -1;
+    free(out);
+    return r;
+}
+
+/* i2c0: switches the controller on and defines the bus pin group */
+static int write_i2c0(const char *dir) {
+    blob_t b = {0};
+    begin_node(&b, "");
+    begin_fragment(&b, 0);
+    prop_str(&b, "status", "okay");
+    end_fragment(&b);
+    begin_fragment(&b, 1);
+    begin_node(&b, "i2c0-pins");
+    prop_pins(&b, "pins", "PD0", "PD12", NULL);
+    end_node(&b);
+    end_fragment(&b);
+    begin_node(&b, "__fixups__");
+    prop_str(&b, "i2c0", "/fragment@0:target:0");
+    prop_str(&b, "pio", "/fragment@1:target:0");
+    end_node(&b);
+    end_node(&b);
+    return write_blob(dir, "i2c0", &b);
+}
+
+/* a device under &i2c0 at addr that repeats the bus pin group */
+static int write_i2c_device(const char *dir, const char *id, const char *node, uint32_t addr) {
+    blob_t b = {0};
+    begin_node(&b, "");
+    begin_fragment(&b, 0);
+    begin_node(&b, node);
+    prop_u32(&b, "reg", addr);
+    prop_str(&b, "status", "okay");
+    end_node(&b);
+    end_fragment(&b);
+    begin_fragment(&b, 1);
+    begin_node(&b, "i2c0-pins");
+    prop_pins(&b, "allwinner,pins", "PD0", "PD12", NULL);
+    end_node(&b);
+    end_fragment(&b);
+    begin_node(&b, "__fixups__");
+    prop_str(&b, "i2c0", "/fragment@0:target:0");
+    prop_str(&b, "pio", "/fragment@1:target:0");
+    end_node(&b);
+    end_node(&b);
+    return write_blob(dir, id, &b);
+}
+
+static int write_uart1(const char *dir) {
+    blob_t b = {0};
+    begin_node(&b, "");
+    begin_fragment(&b, 0);
+    begin_node(&b, "uart1-pins");
+    prop_pins(&b, "pins", "PA2", "PA3", NULL);
+    end_node(&b);
+    end_fragment(&b);
+    begin_node(&b, "__fixups__");
+    prop_str(&b, "pio", "/fragment@0:target:0");
+    end_node(&b);
+    end_node(&b);
+    return write_blob(dir, "uart1", &b);
+}
+
+/* ---- checks ---- */
+
+static int s_failures;
+
+static void fail(int rank, const char *what) {
+    fprintf(stderr, "FAIL rank %d: %s\n", rank, what);
+    s_failures++;
+}
+
+static void check_rank(const cfg_registry_t *base, const overlay_index_t *ox, int rank, device_rev_t rev) {
+    overlay_registry_t r;
+    if (overlay_registry_derive(&r, base, ox, rank) != 0) {
+        fail(rank, "overlay_registry_derive failed");
+        return;
+    }
+    const cfg_registry_t *reg = &r.reg;
+    const int i2c0 = cfg_registry_find(reg, "i2c0");
+    const int cardkb = cfg_registry_find(reg, "cardkb");
+    const int lsm6 = cfg_registry_find(reg, "lsm6ds3_pre0.4");
+    const int uart1 = cfg_registry_find(reg, "uart1");
+    const int adc = cfg_registry_find(reg, "adc_pa123");
+    if (i2c0 < 0 || cardkb < 0 || lsm6 < 0 || uart1 < 0 || adc < 0) {
+        fail(rank, "registry is missing a test item");
+        overlay_registry_free(&r);
+        return;
+    }
+
+    if (cfg_bits_test(cfg_registry_conflicts(reg, rank, (size_t)i2c0), (size_t)cardkb)) fail(rank, "i2c0 conflicts with cardkb");
+    if (cfg_bits_test(cfg_registry_conflicts(reg, rank, (size_t)i2c0), (size_t)lsm6)) fail(rank, "i2c0 conflicts with lsm6ds3");
+    if (cfg_bits_test(cfg_registry_conflicts(reg, rank, (size_t)cardkb), (size_t)lsm6)) fail(rank, "cardkb conflicts with lsm6ds3");
+    if (cfg_bits_test(cfg_registry_enable_conflicts(reg, rank, (size_t)cardkb), (size_t)i2c0)) {
+        fail(rank, "enabling cardkb conflicts with i2c0");
+    }
+    if (!cfg_bits_test(&r.derived, (size_t)i2c0) || reg->items[i2c0].pins[rank] != (CFG_PIN_PD0 | CFG_PIN_PD12)) {
+        fail(rank, "i2c0 pins not read from its overlay");
+    }
+    if (!cfg_bits_test(cfg_registry_conflicts(reg, rank, (size_t)uart1), (size_t)adc)) fail(rank, "uart1 / adc_pa123 overlap lost");
+
+    static const char uenv[] = "interface=i2c0\next=cardkb\n";
+    FILE *fp = fmemopen((void *)uenv, sizeof(uenv) - 1, "r");
+    uenv_file_t u;
+    char err[256];
+    if (!fp || uenv_load_fp(fp, &u, err, sizeof(err)) != 0) {
+        fail(rank, "uenv_load_fp failed");
+    } else {
+        cfg_state_t st;
+        if (cfg_state_init_from_uenv(&st, reg, &u, rev) != 0) {
+            fail(rank, "cfg_state_init_from_uenv failed");
+        } else {
+            if (cfg_state_validate(&st, rev, err, sizeof(err)) != 0) fail(rank, err);
+            /* off and on again: neither is refused as unavailable */
+            if (cfg_state_toggle(&st, (size_t)cardkb, rev, NULL) != 0) fail(rank, "disabling cardkb failed");
+            if (cfg_state_toggle(&st, (size_t)cardkb, rev, NULL) != 0) fail(rank, "enabling cardkb failed");
+            if (rank <= 1 && cfg_state_toggle(&st, (size_t)lsm6, rev, NULL) != 0) fail(rank, "enabling lsm6ds3 next to cardkb failed");
+            cfg_state_free(&st);
+        }
+        uenv_free(&u);
+    }
+    if (fp) fclose(fp);
+    overlay_registry_free(&r);
+}
+
+int main(void) {
+    char dir[] = "/tmp/srgn_overlay_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 2;
+    }
+    setenv("SRGN_CACHE_DIR", "", 1); /* always parse the blobs */
+
+    const cfg_registry_t *base = cfg_registry_builtin();
+    overlay_index_t ox;
+    memset(&ox, 0, sizeof(ox));
+    int ret = 2;
+    if (!base || write_i2c0(dir) != 0 || write_i2c_device(dir, "cardkb", "cardkb@5f", 0x5f) != 0 ||
+        write_i2c_device(dir, "lsm6ds3_pre0.4", "lsm6ds3@6a", 0x6a) != 0 || write_uart1(dir) != 0 ||
+        overlay_scan(&ox, dir, base) != 0) {
+        fprintf(stderr, "setup failed\n");
+        goto out;
+    }
+
+    static const device_rev_t REVS[CFG_REV_RANKS] = {DEVICE_REV_EPASS_0_2, DEVICE_REV_EPASS_0_3_0_4, DEVICE_REV_EPASS_0_5,
+                                                     DEVICE_REV_EPASS_0_6};
+    for (int rank = 0; rank < CFG_REV_RANKS; rank++) check_rank(base, &ox, rank, REVS[rank]);
+    ret = s_failures ? 1 : 0;
+    if (ret == 0) printf("overlay_pins_test: ok\n");
+
+out:
+    overlay_index_free(&ox);
+    static const char *const FILES[] = {"i2c0", "cardkb", "lsm6ds3_pre0.4", "uart1"};
+    for (size_t i = 0; i < sizeof(FILES) / sizeof(FILES[0]); i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.dtbo", dir, FILES[i]);
+        unlink(path);
+    }
+    rmdir(dir);
+    return ret;
+}
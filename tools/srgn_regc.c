@@ -0,0 +1,393 @@
+/*
+ * srgn_regc: registry compiler
+ *
+ * Turns a registry source file into the binary index srgn_config maps at
+ * startup (see config_registry_index.h). Source format, one item per
+ * section:
+ *
+ *   # comment (whole lines only)
+ *   [i2c0]
+ *   cat = interface                  (interface | ext)
+ *   title = i2c0                     (defaults to the id)
+ *   help = Enable I2C0\n(PD0/PD12 as I2C pins)
+ *   min_rev = 0.5                    (optional revision limits)
+ *   max_rev = 0.4
+ *   pins = PD0 PD12                  (every revision)
+ *   pins@0.5 = PA1 PE3               (one revision, after pins =)
+ *   requires = i2c0
+ *   conflicts = other_item           (only for conflicts not about pins)
+ *
+ * usage: srgn_regc SOURCE -o OUT
+ *        srgn_regc --dump-builtin      (print the built-in table as source)
+ */
+
+#define _GNU_SOURCE
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config_registry.h"
+#include "config_registry_index.h"
+
+static const char *const RANK_NAMES[CFG_REV_RANKS] = {"0.2", "0.4", "0.5", "0.6"};
+
+typedef struct {
+    cfg_item_t *items;
+    size_t count;
+    size_t cap;
+} source_t;
+
+static char *trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    char *e = s + strlen(s);
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r' || e[-1] == '\n')) *--e = 0;
+    return s;
+}
+
+/* "\n" and "\\" escapes */
+static char *unescape(const char *s) {
+    char *out = malloc(strlen(s) + 1);
+    if (!out) return NULL;
+    char *d = out;
+    for (; *s; s++) {
+        if (s[0] == '\\' && s[1] == 'n') {
+            *d++ = '\n';
+            s++;
+        } else if (s[0] == '\\' && s[1] == '\\') {
+            *d++ = '\\';
+            s++;
+        } else {
+            *d++ = *s;
+        }
+    }
+    *d = 0;
+    return out;
+}
+
+/* Whitespace-separated list into a NULL-free strdup'ed vector */
+static int split_list(const char *s, const char *const **out, size_t *count) {
+    char *copy = strdup(s);
+    if (!copy) return -1;
+    const char **v = NULL;
+    size_t n = 0;
+    for (char *save = NULL, *tok = strtok_r(copy, " \t", &save); tok; tok = strtok_r(NULL, " \t", &save)) {
+        const char **nv = realloc(v, (n + 1) * sizeof(char *));
+        if (!nv || !(nv[n] = strdup(tok))) {
+            free(nv ? nv : v);
+            free(copy);
+            return -1;
+        }
+        v = nv;
+        n++;
+    }
+    free(copy);
+    *out = v;
+    *count = n;
+    return 0;
+}
+
+static int parse_pins(const char *s, cfg_pins_t *out, const char **bad) {
+    cfg_pins_t pins = 0;
+    const char *const *names = NULL;
+    size_t n = 0;
+    if (split_list(s, &names, &n) != 0) return -1;
+    int ret = 0;
+    for (size_t i = 0; i < n; i++) {
+        const cfg_pins_t p = cfg_pin_from_name(names[i]);
+        if (!p && ret == 0) {
+            *bad = strdup(names[i]);
+            ret = -1;
+        }
+        pins |= p;
+    }
+    for (size_t i = 0; i < n; i++) free((char *)names[i]);
+    free((void *)names);
+    *out = pins;
+    return ret;
+}
+
+static int rank_of(const char *rev) {
+    device_rev_t r;
+    if (device_rev_from_str(rev, &r) != 0) return -1;
+    return device_rev_rank(r);
+}
+
+static int parse_source(FILE *fp, const char *name, source_t *src) {
+    char *line = NULL;
+    size_t cap = 0;
+    size_t lineno = 0;
+    cfg_item_t *it = NULL;
+    int ret = 0;
+
+#define FAIL(...)                                        \
+    do {                                                 \
+        fprintf(stderr, "%s:%zu: ", name, lineno);       \
+        fprintf(stderr, __VA_ARGS__);                    \
+        fputc('\n', stderr);                             \
+        ret = -1;                                        \
+        goto out;                                        \
+    } while (0)
+
+    while (getline(&line, &cap, fp) >= 0) {
+        lineno++;
+        char *s = trim(line);
+        if (!*s || *s == '#') continue;
+
+        if (*s == '[') {
+            char *end = strchr(s, ']');
+            if (!end || end == s + 1 || *trim(end + 1)) FAIL("expected [item_id]");
+            *end = 0;
+            for (size_t i = 0; i < src->count; i++) {
+                if (strcmp(src->items[i].id, s + 1) == 0) FAIL("duplicate item %s", s + 1);
+            }
+            if (src->count == src->cap) {
+                src->cap = src->cap ? src->cap * 2 : 16;
+                cfg_item_t *nv = realloc(src->items, src->cap * sizeof(cfg_item_t));
+                if (!nv) FAIL("out of memory");
+                src->items = nv;
+            }
+            it = &src->items[src->count++];
+            memset(it, 0, sizeof(*it));
+            it->id = strdup(s + 1);
+            it->cat = (cfg_category_t)-1;
+            it->min_rev_rank = -1;
+            it->max_rev_rank = -1;
+            continue;
+        }
+
+        char *eq = strchr(s, '=');
+        if (!eq) FAIL("expected key = value");
+        *eq = 0;
+        char *key = trim(s);
+        char *val = trim(eq + 1);
+        if (!it) FAIL("%s outside of an [item] section", key);
+
+        if (strcmp(key, "cat") == 0) {
+            if (strcmp(val, "interface") == 0) {
+                it->cat = CFG_CAT_INTERFACE;
+            } else if (strcmp(val, "ext") == 0) {
+                it->cat = CFG_CAT_EXT;
+            } else {
+                FAIL("cat must be interface or ext");
+            }
+        } else if (strcmp(key, "title") == 0) {
+            free((char *)it->title);
+            it->title = unescape(val);
+        } else if (strcmp(key, "help") == 0) {
+            free((char *)it->help);
+            it->help = unescape(val);
+        } else if (strcmp(key, "min_rev") == 0 || strcmp(key, "max_rev") == 0) {
+            const int rank = rank_of(val);
+            if (rank < 0) FAIL("unknown revision %s", val);
+            if (key[1] == 'i') {
+                it->min_rev_rank = rank;
+            } else {
+                it->max_rev_rank = rank;
+            }
+        } else if (strcmp(key, "pins") == 0 || strncmp(key, "pins@", 5) == 0) {
+            cfg_pins_t pins = 0;
+            const char *bad = NULL;
+            if (parse_pins(val, &pins, &bad) != 0) {
+                if (bad) {
+                    fprintf(stderr, "%s:%zu: unknown pin %s\n", name, lineno, bad);
+                    free((char *)bad);
+                    ret = -1;
+                    goto out;
+                }
+                FAIL("out of memory");
+            }
+            if (key[4] == 0) {
+                for (int r = 0; r < CFG_REV_RANKS; r++) it->pins[r] = pins;
+            } else {
+                const int rank = rank_of(key + 5);
+                if (rank < 0) FAIL("unknown revision %s", key + 5);
+                it->pins[rank] = pins;
+            }
+        } else if (strcmp(key, "requires") == 0) {
+            if (split_list(val, &it->requires, &it->requires_count) != 0) FAIL("out of memory");
+        } else if (strcmp(key, "conflicts") == 0) {
+            if (split_list(val, &it->conflicts, &it->conflicts_count) != 0) FAIL("out of memory");
+        } else {
+            FAIL("unknown key %s", key);
+        }
+    }
+
+    for (size_t i = 0; i < src->count; i++) {
+        cfg_item_t *x = &src->items[i];
+        if ((int)x->cat < 0) {
+            fprintf(stderr, "%s: item %s has no cat\n", name, x->id);
+            ret = -1;
+        }
+        if (!x->title) x->title = strdup(x->id);
+    }
+#undef FAIL
+
+out:
+    free(line);
+    return ret;
+}
+
+/* ---- --dump-builtin ---- */
+
+static void print_escaped(FILE *fp, const char *s) {
+    for (; *s; s++) {
+        if (*s == '\n') {
+            fputs("\\n", fp);
+        } else if (*s == '\\') {
+            fputs("\\\\", fp);
+        } else {
+            fputc(*s, fp);
+        }
+    }
+}
+
+static void print_pins(FILE *fp, cfg_pins_t pins) {
+    bool first = true;
+    for (unsigned b = 0; b < CFG_PIN_COUNT; b++) {
+        if (!(pins & (1u << b))) continue;
+        fprintf(fp, "%s%s", first ? "" : " ", cfg_pin_name(1u << b));
+        first = false;
+    }
+}
+
+static void dump_registry(FILE *fp, const cfg_registry_t *reg) {
+    fprintf(fp, "# srgn_config registry source (compile with srgn_regc)\n");
+    for (size_t i = 0; i < reg->count; i++) {
+        const cfg_item_t *it = &reg->items[i];
+        fprintf(fp, "\n[%s]\ncat = %s\n", it->id, it->cat == CFG_CAT_EXT ? "ext" : "interface");
+        if (it->title && strcmp(it->title, it->id) != 0) {
+            fputs("title = ", fp);
+            print_escaped(fp, it->title);
+            fputc('\n', fp);
+        }
+        if (it->help) {
+            fputs("help = ", fp);
+            print_escaped(fp, it->help);
+            fputc('\n', fp);
+        }
+        if (it->min_rev_rank >= 0) fprintf(fp, "min_rev = %s\n", RANK_NAMES[it->min_rev_rank]);
+        if (it->max_rev_rank >= 0) fprintf(fp, "max_rev = %s\n", RANK_NAMES[it->max_rev_rank]);
+
+        bool same = true;
+        for (int r = 1; r < CFG_REV_RANKS; r++) same = same && it->pins[r] == it->pins[0];
+        if (same && it->pins[0]) {
+            fputs("pins = ", fp);
+            print_pins(fp, it->pins[0]);
+            fputc('\n', fp);
+        } else if (!same) {
+            for (int r = 0; r < CFG_REV_RANKS; r++) {
+                fprintf(fp, "pins@%s = ", RANK_NAMES[r]);
+                print_pins(fp, it->pins[r]);
+                fputc('\n', fp);
+            }
+        }
+        if (it->requires_count) {
+            fputs("requires =", fp);
+            for (size_t k = 0; k < it->requires_count; k++) fprintf(fp, " %s", it->requires[k]);
+            fputc('\n', fp);
+        }
+        if (it->conflicts_count) {
+            fputs("conflicts =", fp);
+            for (size_t k = 0; k < it->conflicts_count; k++) fprintf(fp, " %s", it->conflicts[k]);
+            fputc('\n', fp);
+        }
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: srgn_regc SOURCE -o OUT\n"
+                    "       srgn_regc --dump-builtin\n");
+}
+
+int main(int argc, char **argv) {
+    const char *in = NULL;
+    const char *out = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump-builtin") == 0) {
+            const cfg_registry_t *reg = cfg_registry_builtin();
+            if (!reg) return 2;
+            dump_registry(stdout, reg);
+            return 0;
+        } else if (strcmp(argv[i], "-o") == 0 && (i + 1) < argc) {
+            out = argv[++i];
+        } else if (argv[i][0] != '-' && !in) {
+            in = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!in || !out) {
+        usage();
+        return 1;
+    }
+
+    FILE *fp = fopen(in, "r");
+    if (!fp) {
+        perror(in);
+        return 2;
+    }
+    source_t src = {0};
+    const int pr = parse_source(fp, in, &src);
+    fclose(fp);
+    /* the strings live until exit */
+    if (pr != 0) return 2;
+    if (src.count > CFG_MAX_ITEMS) {
+        fprintf(stderr, "%s: more than %d items\n", in, CFG_MAX_ITEMS);
+        return 2;
+    }
+
+    cfg_registry_t reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.items = src.items;
+    reg.count = src.count;
+    const uint32_t cap = cfg_registry_hash_capacity(src.count);
+    uint16_t *slots = malloc(cap * sizeof(uint16_t));
+    cfg_bits_t *masks = calloc(CFG_MASK_STORAGE(src.count) + 1, sizeof(cfg_bits_t));
+    if (!slots || !masks || cfg_registry_build_hash(&reg, slots, cap) != 0) {
+        fprintf(stderr, "%s: cannot build the id hash\n", in);
+        return 2;
+    }
+    if (cfg_registry_build_masks(&reg, masks) != 0) {
+        fprintf(stderr, "%s: requires/conflicts name an unknown item\n", in);
+        return 2;
+    }
+
+    /* write next to the target and rename, so a running srgn_config never maps a partial file */
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", out);
+    FILE *of = fopen(tmp, "wb");
+    char err[256];
+    if (!of) {
+        perror(tmp);
+        return 2;
+    }
+    if (cfg_registry_write_index(&reg, of, err, sizeof(err)) != 0) {
+        fprintf(stderr, "%s: %s\n", tmp, err);
+        fclose(of);
+        unlink(tmp);
+        return 2;
+    }
+    if (fclose(of) != 0) {
+        perror(tmp);
+        unlink(tmp);
+        return 2;
+    }
+
+    /* read it back the way srgn_config will */
+    cfg_registry_t check;
+    if (cfg_registry_load_index(tmp, &check, err, sizeof(err)) != 0 || check.count != reg.count) {
+        fprintf(stderr, "srgn_regc: written index does not load: %s\n", err);
+        unlink(tmp);
+        return 2;
+    }
+    if (rename(tmp, out) != 0) {
+        perror(out);
+        unlink(tmp);
+        return 2;
+    }
+    return 0;
+}